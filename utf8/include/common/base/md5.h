@@ -58,6 +58,7 @@ public:
   void update(const char *buf, size_type length);
   MD5& finalize();
   std::string hexdigest() const;
+  void hexdigest(char out[33]) const; // no allocation, out is 32 hex chars and 0
   std::string md5() const;
   friend std::ostream& operator<<(std::ostream&, MD5 md5);
 
@@ -89,6 +90,20 @@ private:
   static inline void II(uint4 &a, uint4 b, uint4 c, uint4 d, uint4 x, uint4 s, uint4 ac);
 };
 
+const int kMD5HexLength = 32;
+
+// allocation free digest, out is 32 lower case hex chars and the terminator
+void md5_hex(const char* str, char out[kMD5HexLength + 1]);
+void md5_hex(const char* data, 
+             MD5::size_type length, 
+             char out[kMD5HexLength + 1]);
+// hash count inputs in parallel lanes (4 lanes with SSE2), for batch password
+// checking, the result is the same as md5_hex
+void md5_hex_multi(const char* const* data, 
+                   const MD5::size_type* length, 
+                   char (*out)[kMD5HexLength + 1], 
+                   int count);
+
 }; //namespace pap_common_base
 
 #endif //COMMON_BASE_MD5_H_
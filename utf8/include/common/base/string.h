@@ -33,23 +33,16 @@ bool string_toint(const char* source,
                   bool ignored_zero = false);
 
 /*string table class {*/
-//cn: 数据量不大的时候可以用这个，否则用map
-/*string table class {*/                                                           
-struct tableitem_t {                                                               
-  char* str;                                                                       
-  void* pointer;                                                                   
-  uint32_t status;                                                                 
-  tableitem_t() {                                                                  
-    str = NULL;                                                                    
-    pointer = NULL;                                                                
-    status = 0;                                                                    
-  };                                                                               
-  ~tableitem_t() {                                                                 
-      SAFE_DELETE_ARRAY(str);                                                        
-      pointer = NULL;                                                                
-      status = 0;                                                                    
-  };                                                                               
-};      
+//cn: 开放寻址哈希表，键内联保存在连续的槽里（不单独分配），
+//    控制字节保存哈希的低7位，每次比较一组16个控制字节
+const uint32_t kTableGroupSize = 16;
+
+struct tableitem_t {
+  uint32_t hash; //完整哈希，比较字符串之前先比较它
+  void* pointer;
+  //之后是键，长度为Table的size
+};
+
 class Table {
 
  public:
@@ -57,25 +50,37 @@ class Table {
    ~Table();
 
  public:
-   enum {
-     kEmpty = 0,
-     kSet = 1,
-     kUse = 2,
+   enum { //control byte, 0-127 is the hash tag of used item
+     kEmpty = -128,
+     kDeleted = -2,
    };
 
  public:
+   //itemmax为最多的项数，size为键的最大长度（包括结尾符）
    void init(uint32_t itemmax, uint32_t size);
-   bool add(const char* str, void* pointer);
+   bool add(const char* str, void* pointer); //已存在则替换
    void* get(const char* str);
    void remove(const char* str);
    void cleanup();
    void* get_byposition(uint32_t position);
    void remove_byposition(uint32_t position);
+   uint32_t get_capacity() const; //位置的范围
+   uint32_t get_count() const;
+
+ private:
+   tableitem_t* get_item(uint32_t position) const;
+   int32_t find(const char* str, uint32_t hash) const; //没有找到返回-1
+   void erase(uint32_t position);
 
  private:
-   tableitem_t* item_;
+   int8_t* control_;
+   char* item_;
+   uint32_t capacity_; //槽数，kTableGroupSize的倍数
+   uint32_t group_mask_; //组数减1，组数是2的幂
+   uint32_t itemmax_;
    uint32_t count_;
    uint32_t size_;
+   uint32_t item_size_; //每个槽的字节数，按指针对齐
 
 };
 /*strint table class}*/
@@ -40,6 +40,43 @@ int charset_convert(const char* from,
                     const char* src, 
                     int srclen) ;
 void password_swap_chars(char* str); //string will more than 32
+uint32_t crc32(const char* data, uint32_t size);
+void memory_barrier(); //完整的内存屏障，发布给其他线程读取的指针前后使用
+bool is_ascii(const char* str, int32_t length); //是否全是7位字符
+//GBK和UTF-8互转，查表实现，表在第一次使用时生成。无法转换的字符被跳过，
+//返回转换后的长度（结果以0结尾），空间不足或表不可用返回-1
+int32_t gbk_toutf8(char* save, 
+                   int32_t savelen, 
+                   const char* src, 
+                   int32_t srclen);
+int32_t utf8_togbk(char* save, 
+                   int32_t savelen, 
+                   const char* src, 
+                   int32_t srclen);
+
+//可重复使用的字符集转换，iconv只在init时打开一次
+class CharsetConverter {
+
+ public:
+   CharsetConverter();
+   ~CharsetConverter();
+
+ public:
+   bool init(const char* from, const char* to);
+   //返回转换后的长度，失败返回负数，结果以0结尾
+   int32_t convert(char* save, 
+                   int32_t savelen, 
+                   const char* src, 
+                   int32_t srclen);
+
+ private:
+   void* handle_; //iconv_t
+
+};
+
+//当前线程缓存的转换器，每对字符集只打开一次，线程退出时释放，
+//不能跨线程使用
+CharsetConverter* get_charset_converter(const char* from, const char* to);
 
 } //namespace util
 
@@ -20,6 +20,10 @@
 
 namespace pap_common_file {
 
+const uint32_t kDatabaseBinaryIdentify = 0XDDBBCC00;
+const uint32_t kDatabaseBinaryVersion = 1;
+const int32_t kDatabaseIndexColumnMax = 4; //组合索引最多的列数
+
 class Database {
 
  public:
@@ -29,7 +33,28 @@ class Database {
      int32_t record_number; //记录数
      int32_t string_block_size; //字符串区大小
    } file_head_t;
+
+   //二进制表格式，可以直接映射使用：
+   //头 | 列类型uint32_t[列数] | 单元uint32_t[记录数*列数](字符串为偏移) |
+   //字符串区(4字节对齐) | 索引binary_index_t[索引数](按key排序)
+   typedef struct {
+     file_head_t head;
+     uint32_t version; //格式版本
+     uint32_t checksum; //头以后所有内容的crc32
+     int32_t index_column; //预先生成的索引列，-1为没有
+     int32_t index_number; //索引项数
+   } binary_head_t;
+
+   typedef struct {
+     int32_t key;
+     int32_t line;
+   } binary_index_t;
    
+   typedef enum { //index type
+     kIndexHash = 0, //开放寻址哈希，等值查询，只支持整数和字符串列
+     kIndexSorted = 1, //有序行号，范围查询
+   } index_type_enum;
+
    typedef enum { //field type
      kTypeInt = 0,
      kTypeFloat = 1,
@@ -50,6 +75,14 @@ class Database {
 
    typedef std::vector<field_data> data_buffer;
 
+   typedef struct {
+     index_type_enum type;
+     int32_t column_number;
+     int32_t column[kDatabaseIndexColumnMax];
+     bool built; //第一次查询时生成
+     std::vector<int32_t> line; //哈希为槽(行号+1, 0为空)，有序为排序后的行号
+   } index_t;
+
  public:
    Database(uint32_t id);
    virtual ~Database();
@@ -68,7 +101,37 @@ class Database {
    uint32_t get_id() const; //获得ID
    int32_t get_field_number() const;
    int32_t get_record_number() const;
+   int32_t get_field_type(int32_t column) const; //失败返回-1
    void create_index(int32_t column = 0, const char* filename = 0);
+   bool save_to_binary(const char* filename); //转换为二进制表
+   //声明索引，返回索引id（相同声明返回同一个），失败返回-1
+   int32_t declare_index(index_type_enum type, int32_t column);
+   int32_t declare_index(index_type_enum type, 
+                         int32_t column1, 
+                         int32_t column2);
+   int32_t declare_index(index_type_enum type, 
+                         const int32_t* column, 
+                         int32_t column_number);
+   void build_index(); //生成所有声明的索引，多线程共享表之前调用
+   //key为索引各列的值，返回第一条匹配记录的行首，索引没有生成时逐行查找
+   const field_data* search_index(int32_t index, const field_data* key) const;
+   int32_t search_index_all(int32_t index, 
+                            const field_data* key, 
+                            std::vector<const field_data*> &result) const;
+   //有序索引，low <= key <= high，按索引顺序返回
+   int32_t search_index_range(int32_t index, 
+                              const field_data* low, 
+                              const field_data* high,
+                              std::vector<const field_data*> &result) const;
+   //按列连续存储的数据，build_column()之后才有，没有生成或类型不符返回NULL
+   //int32_t/float/const char*，长度为get_record_number()
+   template <typename T> const T* column(int32_t index) const;
+   void build_column(); //生成列存储，多线程共享表之前调用
+   //整数列 low <= value <= high 的行号
+   int32_t search_column_range(int32_t index, 
+                               int32_t low, 
+                               int32_t high, 
+                               std::vector<int32_t> &line) const;
 
  public:
    static int32_t convert_string_tovector(const char* source,
@@ -83,6 +146,9 @@ class Database {
    static bool field_equal(field_type_enum type, 
                            const field_data &a, 
                            const field_data &b);
+   static int32_t field_compare(field_type_enum type, 
+                                const field_data &a, 
+                                const field_data &b);
 
  protected:
 #if defined(__SGI_STL_PORT)
@@ -101,6 +167,13 @@ class Database {
    int32_t string_buffer_size_;
    field_hashmap hash_index_;
    int32_t index_column_;
+   char* mapped_memory_; //二进制表映射的内存，字符串直接指向这里
+   uint32_t mapped_size_;
+   std::vector<index_t> index_; //只在declare_index和build_index中修改
+   bool column_built_;
+   std::vector<int32_t> column_offset_; //每列在下面数组中的开始位置
+   std::vector<int32_t> column_value_; //整数和浮点列(按位保存)
+   std::vector<const char*> column_string_; //字符串列
 
  protected:
    bool open_from_memory_text(const char* memory, 
@@ -108,10 +181,39 @@ class Database {
                               const char* filename = 0);
    bool open_from_memory_binary(const char* memory, 
                                 const char* end, 
-                                const char* filename = 0);
+                                const char* filename = 0,
+                                bool copy_string = true);
+   bool open_from_mapping(const char* filename);
+   //查找已经声明的索引，没有时返回-1
+   int32_t find_index(index_type_enum type, 
+                      const int32_t* column, 
+                      int32_t column_number) const;
+   int32_t get_index(index_type_enum type, 
+                     const int32_t* column, 
+                     int32_t column_number);
+   void build_index(int32_t index);
+   void reset_index(); //数据重新载入后索引和列存储需要重新生成
+   void create_column();
+   //没有生成索引时逐行比较，low <= key <= high的行号按行号顺序返回
+   void scan_index(const index_t &index, 
+                   const field_data* low, 
+                   const field_data* high, 
+                   std::vector<int32_t> &line) const;
+   uint32_t index_hash(const index_t &index, const field_data* key) const;
+   int32_t index_compare(const index_t &index, 
+                         int32_t line, 
+                         const field_data* key) const;
+   friend struct IndexLess;
 
 };
 
+template <> 
+const int32_t* Database::column<int32_t>(int32_t index) const;
+template <> 
+const float* Database::column<float>(int32_t index) const;
+template <> 
+const char* const* Database::column<const char*>(int32_t index) const;
+
 }; //namespace pap_common_file
 
 #endif //PAP_COMMON_FILE_DATABASE_H_
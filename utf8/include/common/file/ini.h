@@ -102,6 +102,23 @@ class Ini {
    int32_t line_, row_; //当前行列
    char value_[INI_VALUE_MAX];
    char ret_[INI_VALUE_MAX];
+   char key_[INI_VALUE_MAX]; //find_key的结果
+
+ private:
+   //open时解析一次，按节和键哈希，读取时不再扫描文本
+   typedef struct {
+     uint32_t hash;
+     int32_t section; //节名在text_中的偏移
+     int32_t key; //键名偏移，-1为节本身
+     int32_t value; //值偏移
+     bool int_cached; //转换过的值，第一次读取时转换
+     bool float_cached;
+     int64_t int_value;
+     float float_value;
+   } entry_t;
+   std::vector<char> text_;
+   std::vector<entry_t> entry_;
+   std::vector<int32_t> entry_slot_; //开放寻址，值为entry_下标，-1为空
 
  private:
    void init_section();
@@ -117,6 +134,9 @@ class Ini {
    //在当前位置修改数据
    bool modify_data(int32_t index, const char* key, const char* value);
    int32_t goto_last_line(const char* section);
+   void build_index(); //数据改变后重新生成
+   entry_t* find_entry(const char* section, const char* key = NULL);
+   int64_t get_int64(entry_t* entry);
 
 };
 
@@ -0,0 +1,105 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id registry.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-14 10:21:36
+ * @uses the table registry, reload database files when they changed.
+ *       cn: 表格注册表，文件改变或收到重载命令时在后台线程载入新表，
+ *           原子替换指针，旧表在所有读者离开后释放，读者不加锁
+ */
+#ifndef PAP_COMMON_FILE_REGISTRY_H_
+#define PAP_COMMON_FILE_REGISTRY_H_
+
+#include "common/file/config.h"
+#include "common/file/database.h"
+#include "common/sys/thread.h"
+
+namespace pap_common_file {
+
+const int32_t kRegistryTableMax = 64;
+const int32_t kRegistryReaderSlotMax = 32; //读者计数分散到多个槽，减少争用
+const uint32_t kRegistryCheckTime = 1000; //检查文件的间隔(毫秒)
+
+//新表发布之前调用，声明需要的索引（发布时生成）或生成列存储，
+//返回false则放弃这次载入
+typedef bool (*table_prepare_function)(uint32_t id, Database* database);
+
+class Registry : public pap_common_sys::Thread {
+
+ public:
+   typedef struct {
+     uint32_t id;
+     char filename[FILENAME_MAX];
+     table_prepare_function prepare;
+     Database* volatile database;
+     volatile bool reload; //重载命令
+     uint32_t version; //成功载入的次数
+     int64_t modify_time;
+     int32_t watch; //inotify监视的目录
+   } table_t;
+
+   typedef struct {
+     volatile int32_t count[2]; //按纪元奇偶计数
+     char padding[64 - sizeof(int32_t) * 2]; //独占一条缓存行
+   } reader_slot_t;
+
+ public:
+   Registry();
+   ~Registry();
+
+ public:
+   //同步载入并注册，需要在start之前调用
+   bool add(uint32_t id,
+            const char* filename,
+            table_prepare_function prepare = NULL);
+   bool reload(uint32_t id); //投递重载命令，由后台线程执行
+   uint32_t get_version(uint32_t id);
+   //读者进入和离开，两者之间得到的表不会被释放，一般使用RegistryReader
+   int32_t read_begin(uint32_t &parity);
+   void read_end(int32_t slot, uint32_t parity);
+   const Database* get(uint32_t id);
+   virtual void run();
+   virtual void stop();
+   bool is_active();
+
+ private:
+   table_t* find(uint32_t id);
+   bool load(table_t* table); //载入并发布新表
+   void synchronize(); //等待切换前进入的读者全部离开
+   void check_modify(); //没有inotify时检查文件修改时间
+
+ private:
+   bool active_;
+   table_t table_[kRegistryTableMax];
+   int32_t table_count_;
+   volatile uint32_t epoch_;
+   reader_slot_t reader_[kRegistryReaderSlotMax];
+   int32_t watch_handle_;
+
+};
+
+//读者在栈上使用，析构时离开，期间get得到的表都有效
+class RegistryReader {
+
+ public:
+   explicit RegistryReader(Registry &registry);
+   ~RegistryReader();
+
+ public:
+   const Database* get(uint32_t id);
+
+ private:
+   Registry &registry_;
+   int32_t slot_;
+   uint32_t parity_;
+
+};
+
+}; //namespace pap_common_file
+
+extern pap_common_file::Registry g_table_registry;
+
+#endif //PAP_COMMON_FILE_REGISTRY_H_
@@ -54,6 +54,9 @@ class Base {
 
  public:
    virtual void cleanup() {};
+   //服务器之间的请求和回应带有请求ID，不支持的消息为0
+   virtual uint32_t get_requestid() const { return 0; };
+   virtual void set_requestid(uint32_t requestid) { USE_PARAM(requestid); };
    virtual bool read(socket::InputStream& inputstream) = 0;
    virtual bool write(socket::OutputStream& outputstream) const = 0;
    virtual uint32_t execute(
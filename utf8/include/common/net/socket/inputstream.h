@@ -21,12 +21,16 @@ class InputStream {
    
  public:
    uint32_t read(char* buffer, uint32_t length);
+   //追加原始数据，交接连接时写回还没有处理的输入
+   uint32_t write(const char* buffer, uint32_t length);
    bool readpacket(packet::Base* packet);
    bool peek(char* buffer, uint32_t length);
    bool skip(uint32_t length);
    uint32_t fill();
    void init();
    bool resize(int32_t size);
+   //保证还能写入length字节，之后的写不会再扩容
+   bool reserve(uint32_t length);
    uint32_t reallength();
    bool isempty();
    void cleanup();
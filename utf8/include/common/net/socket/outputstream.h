@@ -25,6 +25,8 @@ class OutputStream {
    uint32_t flush();
    void init();
    bool resize(int32_t size);
+   //保证还能写入length字节，之后的写不会再扩容
+   bool reserve(uint32_t length);
    uint32_t reallength();
    bool isempty();
    void cleanup();
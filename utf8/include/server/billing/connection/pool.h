@@ -28,6 +28,7 @@ class Pool {
    bool init();
    Server* get(int16_t id);
    Server* create(); //new
+   Server* create(int16_t id); //取指定的位置，交接连接时保持原来的ID
    void remove(int16_t id); //delete
    void lock();
    void unlock();
@@ -36,6 +36,7 @@ class Server : public Billing {
    virtual bool islogin();
    virtual bool isbilling();
    void setstatus(uint32_t status);
+   uint32_t getstatus() const;
    virtual bool isvalid();
    virtual bool sendpacket(pap_common_net::packet::Base* packet);
    pap_server_common_base::server_data_t* get_serverdata();
@@ -0,0 +1,98 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id credentialcache.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-20 11:05:23
+ * @uses the account credential cache of billing.
+ *       cn: 账号验证缓存，保存加密后的密码和不存在的账号，按账号分片加锁，
+ *           每片按LRU淘汰，记录过期后重新查询数据库
+ */
+#ifndef PAP_SERVER_BILLING_DB_USER_CREDENTIALCACHE_H_
+#define PAP_SERVER_BILLING_DB_USER_CREDENTIALCACHE_H_
+
+#include "common/base/type.h"
+#include "common/base/string.h"
+#include "common/sys/thread.h"
+#include "common/game/define/macros.h"
+
+namespace db {
+
+namespace user {
+
+const uint8_t kPasswordEncryptLength = 34; //"0x"加上32位十六进制
+const uint32_t kCredentialCacheShardMax = 16;
+const uint32_t kCredentialCacheMax = 65536;
+const uint32_t kCredentialCacheTime = 600; //记录有效时间(秒)
+const uint32_t kCredentialCacheNotExistTime = 60; //不存在的账号有效时间(秒)
+
+typedef enum {
+  kCredentialMiss = 0, //没有记录或已过期，需要查询数据库
+  kCredentialRight = 1,
+  kCredentialWrong = 2, //密码错误
+  kCredentialNotExist = 3,
+} credential_result_enum;
+
+//与数据库中password = '%s'的比较一致：不区分大小写，忽略结尾的空格
+bool password_equal(const char* password1, const char* password2);
+
+class CredentialCache {
+
+ public:
+   typedef struct {
+     char account[ACCOUNTLENGTH_MAX + 1];
+     char password[kPasswordEncryptLength + 1]; //加密后的密码
+     bool exist;
+     uint32_t expire_time;
+     int32_t previous; //LRU链表，-1为结尾，空闲时next为空闲链表
+     int32_t next;
+   } credential_t;
+
+   typedef struct {
+     pap_common_sys::ThreadLock lock;
+     pap_common_base::string::Table index; //账号到credential_t*
+     credential_t* credential;
+     int32_t head; //最近使用的
+     int32_t tail;
+     int32_t free;
+     uint32_t hit_count;
+     uint32_t miss_count;
+   } shard_t;
+
+ public:
+   CredentialCache();
+   ~CredentialCache();
+
+ public:
+   bool init(uint32_t capacity = kCredentialCacheMax, 
+             uint32_t cache_time = kCredentialCacheTime,
+             uint32_t notexist_time = kCredentialCacheNotExistTime);
+   //password为加密后的密码
+   credential_result_enum check(const char* account, const char* password);
+   //password为NULL表示账号不存在
+   void set(const char* account, const char* password);
+   void remove(const char* account); //修改密码或删除账号时调用
+   void cleanup();
+   void get_count(uint32_t &hit_count, uint32_t &miss_count);
+
+ private:
+   shard_t* get_shard(const char* account);
+   void link(shard_t* shard, int32_t position); //放到链表头
+   void unlink(shard_t* shard, int32_t position);
+   void release(shard_t* shard, int32_t position); //移除并放回空闲链表
+
+ private:
+   shard_t shard_[kCredentialCacheShardMax];
+   int32_t shard_size_; //每片的记录数
+   uint32_t cache_time_;
+   uint32_t notexist_time_;
+
+};
+
+}; //namespace user
+
+}; //namespace db
+
+#endif //PAP_SERVER_BILLING_DB_USER_CREDENTIALCACHE_H_
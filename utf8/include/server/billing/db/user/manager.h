@@ -12,11 +12,35 @@
 #define PAP_SERVER_BILLING_DB_USER_MANAGER_H_
 
 #include "server/common/db/manager.h"
+#include "server/billing/db/user/credentialcache.h"
 
 namespace db {
 
 namespace user {
 
+//密码加密算法，一次处理count个密码，结果以0结尾
+typedef void (*password_kdf_function)(
+    const char* const* password, 
+    char (*out)[kPasswordEncryptLength + 1], 
+    int32_t count);
+
+const uint8_t kYuanbaoKeyLength = 32; //请求的幂等键，由游戏服务器生成
+
+typedef struct {
+  char account[ACCOUNTLENGTH_MAX + 1];
+  uint32_t balance; //元宝余额
+  uint32_t day_cost; //cost_day当天已经消费的
+  uint32_t cost_day; //20140123
+} yuanbao_record_t;
+
+typedef struct {
+  char account[ACCOUNTLENGTH_MAX + 1];
+  char key[kYuanbaoKeyLength + 1];
+  int32_t amount; //正数为增加，负数为消费
+  uint32_t balance; //之后的余额
+  uint32_t time;
+} yuanbao_journal_t;
+
 class Manager {
 
  public:
@@ -50,11 +74,42 @@ class Manager {
    bool deleteuser(const char* username);
    uint32_t get_usercount();
    bool is_haveuser(const char* username);
+   //先查验证缓存，没有命中才查询数据库并缓存结果（包括账号不存在）
    bool is_realuser(const char* username, const char* password);
+   //只查验证缓存，不访问数据库
+   credential_result_enum check_credential(const char* username, 
+                                           const char* password);
    void passwordencrypt(const char* in, char* out, uint8_t length);
+   //同时到达的多个密码一起加密，默认算法是多路并行的md5
+   void passwordencrypt_batch(const char* const* in, 
+                              char (*out)[kPasswordEncryptLength + 1], 
+                              int32_t count);
+   //换成更强的算法（如多轮迭代的KDF），数据库里的密码需要同时迁移
+   void set_password_kdf(password_kdf_function function);
+   //元宝余额，没有记录时record为0，数据库错误返回false
+   bool load_yuanbao(const char* account, yuanbao_record_t &record);
+   bool save_yuanbao(const yuanbao_record_t* record, int32_t count);
+   //只追加的元宝日志，相同的键只写一次
+   bool save_yuanbao_journal(const yuanbao_journal_t* journal, int32_t count);
+   //time不早于since的日志键，重启后继续去重
+   int32_t load_yuanbao_journal(uint32_t since, 
+                                std::vector<yuanbao_journal_t> &result);
+
+ public:
+   static void password_kdf_md5(const char* const* password, 
+                                char (*out)[kPasswordEncryptLength + 1], 
+                                int32_t count);
 
  private:
    pap_server_common_db::ODBCInterface* user_odbcinterface_;
+   password_kdf_function password_kdf_;
+   CredentialCache credentialcache_;
+
+ private:
+   //多条记录的VALUES拼成尽量少的语句执行
+   bool execute_values(const char* head, 
+                       const char* tail, 
+                       const std::vector<std::string> &value);
 
 };
 
@@ -12,9 +12,10 @@
 #define PAP_SERVER_BILLING_MAIN_ACCOUNTTABLE_H_
 
 #include "common/base/type.h"
-#include "common/base/string.h"
 #include "common/game/define/macros.h"
 
+const uint32_t kAccountTableId = 1; //在g_table_registry中的id
+
 class AccountTable {
 
  public:
@@ -22,16 +23,11 @@ class AccountTable {
    ~AccountTable() {};
 
  public:
-   bool init();
+   bool init(); //注册到g_table_registry，文件修改后自动重新载入
    bool check(const char* username, const char* password);
 
- private:
-   pap_common_base::string::map strmap_;
-   int32_t count_;
-
 };
 
 extern AccountTable g_accounttable;
 
 #endif //PAP_SERVER_BILLING_MAIN_ACCOUNTTABLE_H_
-
@@ -0,0 +1,100 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id handoff.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-24 17:06:41
+ * @uses the socket handoff of billing.
+ *       cn: 不停服重启，新进程带-handoff启动后通过本地套接字向旧进程要
+ *           侦听句柄和所有连接的句柄(SCM_RIGHTS)，同时取得连接的状态、
+ *           还没有处理的输入和还没有发出的输出。旧进程交出之前放行所有排队
+ *           的请求并写回元宝数据，新进程恢复完成确认后旧进程退出，
+ *           没有确认时旧进程继续服务。只支持linux，只在主循环线程使用
+ */
+#ifndef PAP_SERVER_BILLING_MAIN_HANDOFF_H_
+#define PAP_SERVER_BILLING_MAIN_HANDOFF_H_
+
+#include "server/common/base/config.h"
+#include "server/common/base/define.h"
+#include "common/net/config.h"
+
+const char* const kHandoffFile = "./billing.handoff"; //本地套接字的路径
+const uint32_t kHandoffVersion = 1; //两边的版本不同时不交接
+const uint32_t kHandoffWaitTime = 30; //等待对方的时间(秒)
+//旧进程在主循环里读新进程的版本，读不到就当作不是交接的连接(毫秒)
+const uint32_t kHandoffRequestTime = 100;
+const uint32_t kHandoffConnectionMax = 65535;
+const uint32_t kHandoffBufferMax = 64 * 1024 * 1024; //和服务器连接的缓存上限
+
+class Handoff {
+
+ public:
+   typedef struct {
+     int16_t id; //连接池中的位置
+     uint32_t status;
+     char host[IP_SIZE];
+     uint16_t port;
+     uint32_t input_length; //还没有处理的输入
+     uint32_t output_length; //还没有发出的输出
+   } connection_t;
+
+   typedef struct {
+     uint32_t version;
+     uint32_t count; //后面跟着的连接数
+     int16_t serverhash[OVER_SERVER_MAX];
+   } head_t;
+
+   typedef struct {
+     connection_t connection;
+     int32_t socketid;
+     std::vector<char> buffer; //输入在前，输出在后
+   } record_t;
+
+ public:
+   Handoff();
+   ~Handoff();
+
+ public:
+   //旧进程，filename为本地套接字的路径
+   bool listen(const char* filename);
+   bool is_requested(); //心跳中调用，新进程连上时返回true
+   bool send_head(int32_t socketid, const head_t &head); //socketid为侦听句柄
+   bool send_connection(const connection_t &connection,
+                        int32_t socketid,
+                        const char* buffer);
+   bool wait_confirm(); //新进程确认后返回true，之后不能再处理任何连接
+   void cancel(); //交接失败，断开新进程继续服务
+   bool is_done() const;
+
+ public:
+   //新进程，连接旧进程并接收所有数据
+   bool receive(const char* filename);
+   int32_t get_listen_socketid() const; //没有收到时为SOCKET_INVALID
+   const head_t &get_head() const;
+   const std::vector<record_t> &get_record() const;
+   bool confirm(); //恢复完成后通知旧进程退出
+
+ private:
+   //句柄随第一个字节发出
+   bool send_socket(const void* data, uint32_t length, int32_t socketid);
+   bool receive_socket(void* data, uint32_t length, int32_t &socketid);
+   bool send_all(const void* data, uint32_t length);
+   bool receive_all(void* data, uint32_t length);
+   void close_peer();
+   void close_received(); //接收失败时关闭已经收到的句柄
+
+ private:
+   int32_t listen_socketid_; //本地套接字
+   int32_t peer_socketid_;
+   int32_t server_socketid_; //收到的服务器侦听句柄
+   head_t head_;
+   std::vector<record_t> record_;
+   bool done_;
+
+};
+
+extern Handoff g_handoff;
+
+#endif //PAP_SERVER_BILLING_MAIN_HANDOFF_H_
@@ -0,0 +1,90 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id loginqueue.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-22 10:36:18
+ * @uses the login admission queue of billing.
+ *       cn: 登录排队，账号表或验证缓存能确定结果的请求直接返回，其余的
+ *           进入队列，心跳时按[LoginQueue]TurnPlayerCount(每秒)放行并查询
+ *           数据库，ReloginTime内重新登录的账号走优先通道。只在主循环线程
+ *           使用
+ */
+#ifndef PAP_SERVER_BILLING_MAIN_LOGINQUEUE_H_
+#define PAP_SERVER_BILLING_MAIN_LOGINQUEUE_H_
+
+#include "common/base/type.h"
+#include "common/game/define/macros.h"
+#include "server/common/base/config.h"
+
+const uint32_t kLoginQueueMax = 32768; //每个通道的容量
+const uint32_t kLoginQueueRecentMax = 16384; //记录最近登录成功的账号
+const uint32_t kLoginQueueLogTime = 10000; //有人排队时输出状态的间隔(毫秒)
+
+class LoginQueue {
+
+ public:
+   typedef enum {
+     kLaneRelogin = 0, //优先通道
+     kLaneNormal = 1,
+     kLaneMax,
+   } lane_enum;
+
+   typedef struct {
+     int16_t connectionid; //发来请求的登录服务器连接
+     uint16_t playerid;
+     char account[ACCOUNTLENGTH_MAX + 1];
+     char password[MD5SIZE_MAX + 1];
+     uint32_t time; //进入队列的时间
+     uint32_t requestid; //登录服务器的请求ID，0为没有
+   } request_t;
+
+   typedef struct {
+     request_t* request;
+     uint32_t head; //序号，位置为序号对容量取余
+     uint32_t tail;
+   } lane_t;
+
+   typedef struct {
+     uint32_t key; //账号的crc32
+     uint32_t time;
+   } recent_t;
+
+ public:
+   LoginQueue();
+   ~LoginQueue();
+
+ public:
+   bool init(uint32_t capacity = kLoginQueueMax);
+   //不查询数据库就能确定结果时直接返回结果，返回false时需要排队
+   bool admit_cached(const request_t &request, uint32_t now);
+   //返回排队的位置(从1开始)，队列满返回0
+   uint32_t push(const request_t &request, uint32_t now);
+   void tick(uint32_t now); //放行并验证，在心跳中调用
+   void flush(uint32_t now); //不限速放行所有排队的请求，交接前调用
+   uint32_t get_size() const;
+   uint32_t get_wait_time(uint32_t position) const; //估计的等待时间(毫秒)
+
+ private:
+   bool is_relogin(const char* account, uint32_t now) const;
+   void set_login(const char* account, uint32_t now);
+   void admit(const request_t &request, uint32_t now); //验证并返回结果
+   void send_result(const request_t &request, bool right, uint32_t now);
+   uint32_t get_turn_count() const; //每秒放行的人数，0为不限制
+
+ private:
+   lane_t lane_[kLaneMax];
+   uint32_t capacity_;
+   recent_t recent_[kLoginQueueRecentMax];
+   uint32_t admit_token_; //可以放行的人数(千分之一)
+   uint32_t last_time_;
+   uint32_t log_time_;
+   pap_server_common_base::ConfigCache config_cache_;
+
+};
+
+extern LoginQueue g_loginqueue;
+
+#endif //PAP_SERVER_BILLING_MAIN_LOGINQUEUE_H_
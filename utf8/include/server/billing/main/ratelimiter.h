@@ -0,0 +1,71 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id ratelimiter.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-21 15:12:47
+ * @uses the token bucket rate limiter of billing.
+ *       cn: 令牌桶限速，按IP或账号的哈希放在固定大小的表里，令牌随时间恢复，
+ *           桶装满后的位置可以被新的键使用，不需要清理。只在主循环线程使用
+ */
+#ifndef PAP_SERVER_BILLING_MAIN_RATELIMITER_H_
+#define PAP_SERVER_BILLING_MAIN_RATELIMITER_H_
+
+#include "common/base/type.h"
+
+const uint32_t kRateLimiterProbeMax = 8; //冲突时最多查找的位置
+const uint32_t kRateLimiterTokenUnit = 1000; //令牌按千分之一计算
+const uint32_t kIpRateLimiterSize = 4096;
+const uint32_t kIpRateLimiterRate = 20; //每秒恢复的令牌
+const uint32_t kIpRateLimiterBurst = 60; //桶的容量
+const uint32_t kAccountRateLimiterSize = 16384;
+const uint32_t kAccountRateLimiterRate = 1;
+const uint32_t kAccountRateLimiterBurst = 5;
+//接入的是登录服务器，数量少，只防止反复重连
+const uint32_t kAcceptRateLimiterSize = 256;
+const uint32_t kAcceptRateLimiterRate = 1;
+const uint32_t kAcceptRateLimiterBurst = 10;
+
+class RateLimiter {
+
+ public:
+   typedef struct {
+     uint32_t key; //0为空
+     uint32_t token; //上次更新时的令牌数(千分之一)
+     uint32_t time; //上次更新的时间(毫秒)
+   } bucket_t;
+
+ public:
+   RateLimiter();
+   ~RateLimiter();
+
+ public:
+   //size为表大小（取2的幂），rate为每秒恢复的令牌数，burst为桶的容量
+   bool init(uint32_t size, uint32_t rate, uint32_t burst);
+   //取一个令牌，没有令牌返回false，now为毫秒时间
+   bool acquire(uint32_t key, uint32_t now);
+   bool acquire(const char* key, uint32_t now);
+   //按IP限速时都使用主机字节序的IPv4地址作为键，无法解析的地址共用一个桶
+   bool acquire_ip(uint32_t ip, uint32_t now);
+   bool acquire_ip(const char* ip, uint32_t now);
+   uint32_t get_reject_count() const;
+
+ private:
+   uint32_t get_token(const bucket_t &bucket, uint32_t now) const; //恢复后的令牌数
+
+ private:
+   bucket_t* bucket_;
+   uint32_t mask_;
+   uint32_t rate_;
+   uint32_t burst_; //千分之一
+   uint32_t reject_count_;
+
+};
+
+extern RateLimiter g_ip_ratelimiter; //玩家IP，验证请求时使用
+extern RateLimiter g_accept_ratelimiter; //服务器地址，接受连接时使用
+extern RateLimiter g_account_ratelimiter;
+
+#endif //PAP_SERVER_BILLING_MAIN_RATELIMITER_H_
@@ -26,6 +26,7 @@
 #include "server/billing/connection/server.h"
 #include "server/common/net/socket.h"
 #include "server/common/base/define.h"
+#include "server/common/base/config.h"
 #include "common/sys/thread.h"
 
 
@@ -61,6 +62,10 @@ class ServerManager : public billingconnection::Manager {
    //服务器广播
    void broadcast(pap_common_net::packet::Base* packet);
    bool connectserver(); //just test
+   //把侦听和所有连接交给新进程，成功后主循环退出
+   bool send_handoff();
+   //恢复从旧进程收到的连接，在连接池初始化以后调用
+   bool receive_handoff();
 
  public:
    uint64_t threadid_;
@@ -86,6 +91,9 @@ class ServerManager : public billingconnection::Manager {
    int32_t fdsize_;
    bool active_;
    billingconnection::Server billing_serverconnection_;
+   pap_server_common_base::ConfigCache config_cache_;
+   uint32_t config_version_; //消息统计使用的配置版本
+   uint32_t reload_checktime_; //上次检查reload.cmd的时间
 
 };
 
@@ -0,0 +1,135 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id yuanbaoledger.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-24 11:20:36
+ * @uses the yuanbao ledger of billing.
+ *       cn: 元宝账本，余额保存在内存里，消费和增加直接在内存中计算并检查每日
+ *           消费上限。每个请求带幂等键，重试的请求返回第一次的结果。变化写入
+ *           只追加的日志，日志按组提交到数据库，提交后再写回余额。
+ *           只在主循环线程使用
+ */
+#ifndef PAP_SERVER_BILLING_MAIN_YUANBAOLEDGER_H_
+#define PAP_SERVER_BILLING_MAIN_YUANBAOLEDGER_H_
+
+#include "server/common/base/config.h"
+#include "server/billing/db/user/manager.h"
+#include "common/base/string.h"
+
+const uint32_t kYuanbaoAccountMax = 65536; //内存中最多的账号
+const uint32_t kYuanbaoResultMax = 65536; //去重保存的最近请求结果，2的幂
+const uint32_t kYuanbaoJournalMax = 8192; //还没有提交的日志上限
+const uint32_t kYuanbaoCommitBatch = 128; //日志达到这个数量立即提交
+const uint32_t kYuanbaoCommitTime = 1; //提交的间隔(秒)
+const uint32_t kYuanbaoDedupeTime = 86400; //启动时载入这么久以内的日志键(秒)
+//去重按账号和幂等键，幂等键里没有|，拼起来不会重复
+const uint32_t kYuanbaoResultKeyLength =
+  db::user::kYuanbaoKeyLength + 1 + ACCOUNTLENGTH_MAX;
+
+typedef enum {
+  kYuanbaoSuccess = 0,
+  kYuanbaoNotEnough = 1, //余额不足
+  kYuanbaoDayLimit = 2, //超过每日消费上限
+  kYuanbaoBusy = 3, //日志提交不过来或者账号太多，稍后重试
+  kYuanbaoInvalid = 4, //参数错误
+  kYuanbaoError = 5, //数据库错误
+} yuanbao_result_enum;
+
+typedef struct {
+  uint8_t result; //yuanbao_result_enum
+  uint32_t balance;
+  //日志序号，get_committed_sequence()不小于它时才已经写入数据库，
+  //调用者应该到那时再回应
+  uint32_t sequence;
+  bool duplicate; //重复的请求，返回的是第一次的结果
+} yuanbao_reply_t;
+
+class YuanbaoLedger {
+
+ public:
+   typedef struct {
+     char account[ACCOUNTLENGTH_MAX + 1];
+     uint32_t balance;
+     uint32_t day_cost;
+     uint32_t cost_day;
+     bool used;
+     bool dirty; //余额需要写回，不能换出
+     bool visited; //换出时的时钟标记
+   } account_t;
+
+   typedef struct {
+     char key[kYuanbaoResultKeyLength + 1]; //幂等键|账号
+     uint32_t balance;
+     uint32_t sequence;
+     bool used;
+   } result_t;
+
+ public:
+   YuanbaoLedger();
+   ~YuanbaoLedger();
+
+ public:
+   //载入最近的日志键继续去重，now为秒
+   bool init(uint32_t now, uint32_t accountmax = kYuanbaoAccountMax);
+   yuanbao_result_enum cost(const char* account,
+                            const char* key,
+                            uint32_t amount,
+                            uint32_t now,
+                            yuanbao_reply_t* reply);
+   yuanbao_result_enum add(const char* account,
+                           const char* key,
+                           uint32_t amount,
+                           uint32_t now,
+                           yuanbao_reply_t* reply);
+   yuanbao_result_enum get_balance(const char* account, uint32_t &balance);
+   uint32_t get_committed_sequence() const;
+   void tick(uint32_t now); //按组提交
+   bool flush(uint32_t now); //提交所有日志和余额，失败的下次重试
+   uint32_t get_pending_count() const;
+
+ private:
+   yuanbao_result_enum apply(const char* account,
+                             const char* key,
+                             int32_t amount,
+                             uint32_t now,
+                             yuanbao_reply_t* reply);
+   account_t* get_account(const char* account, yuanbao_result_enum &result);
+   account_t* alloc_account();
+   result_t* find_result(const char* account, const char* key);
+   void add_result(const char* account,
+                   const char* key,
+                   uint32_t balance,
+                   uint32_t sequence);
+   static void get_result_key(const char* account,
+                              const char* key,
+                              char* result_key);
+   void set_dirty(account_t* account);
+   uint32_t get_max_day_cost() const;
+   //只允许字母数字和:-_，同时保证拼进SQL语句是安全的
+   static bool is_valid_key(const char* key);
+
+ private:
+   account_t* account_;
+   uint32_t accountmax_;
+   int32_t* free_; //空位栈
+   uint32_t free_number_;
+   uint32_t hand_; //换出的时钟指针
+   pap_common_base::string::Table account_table_; //账号到account_t
+   result_t* result_; //环形保存最近成功的请求
+   uint32_t result_position_;
+   pap_common_base::string::Table result_table_; //账号和幂等键到result_t
+   std::vector<db::user::yuanbao_journal_t> journal_; //还没有提交的日志
+   std::vector<int32_t> dirty_;
+   uint32_t sequence_;
+   uint32_t committed_sequence_;
+   uint32_t commit_time_;
+   pap_server_common_base::ConfigCache config_cache_;
+
+};
+
+extern YuanbaoLedger g_yuanbao_ledger;
+
+#endif //PAP_SERVER_BILLING_MAIN_YUANBAOLEDGER_H_
@@ -14,6 +14,7 @@
 #include "server/common/base/define.h"
 #include "common/game/define/all.h"
 #include "common/base/type.h"
+#include "common/sys/thread.h"
 
 namespace pap_server_common_base {
   
@@ -49,6 +50,19 @@ typedef struct {
   uint32_t packet_audit_time; //统计网络包的发送数量、频率的时间间隔。为0时为不统计
 } time_setting_t;
 
+typedef struct {
+  uint32_t throttle_count; //一个统计周期内连接的消息数超过时暂停处理，0为不限制
+  uint32_t kick_count; //一个统计周期内连接的消息数超过时断开，0为不限制
+  uint32_t kick_packet_count; //同一种消息超过时断开，0为不限制
+  bool dump; //每个统计周期结束时把有消息的连接写入日志
+} packet_audit_setting_t;
+
+typedef struct {
+  uint32_t turn_player_count; //billing每秒放行验证的人数，0为不限制
+  bool relogin_limit; //最近登录成功的账号走优先通道
+  uint32_t relogin_time; //登录成功后多久以内算重新登录(毫秒)
+} login_queue_setting_t;
+
 typedef struct {
   uint32_t max_count; //游戏世界的怪物数量上限
   uint32_t default_respawn_time; //缺省的怪物重生时间
@@ -321,6 +335,8 @@ struct config_info_t {
   localization_setting_t localization;
   zone_setting_t zone;
   time_setting_t time;
+  packet_audit_setting_t packet_audit;
+  login_queue_setting_t login_queue;
   monster_setting_t monster;
   portal_setting_t portal;
   platform_setting_t platform;
@@ -436,6 +452,12 @@ struct share_memory_info_t {
   int8_t db_type_enum; //数据库类型 0 mysql, 1 sqlserver, 2 mongodb
   uint32_t world_data_save_interval;
   uint32_t human_data_save_interval;
+  int32_t backend_type; //0 shmget, 1 文件映射
+  bool huge_page; //文件映射时是否使用大页
+  char mmap_file_path[FILENAME_MAX]; //文件映射的目录
+  char snapshot_path[FILENAME_MAX]; //快照的目录，需要持久保存
+  bool journal; //是否记录共享内存的变化日志
+  char journal_path[FILENAME_MAX]; //变化日志的目录
   share_memory_info_t();
   ~share_memory_info_t();
 };
@@ -550,6 +572,14 @@ struct internal_ip_of_proxy_t {
   isp_enum ip_from(const char* ip);
 };
 
+//可以重新载入的配置，每次载入生成一个新的只读快照
+struct config_snapshot_t {
+  uint32_t version;
+  config_info_t config_info;
+};
+
+const int32_t kConfigCacheMax = 128; //最多的线程缓存数量
+
 //structs end --
 
 //--class start
@@ -587,6 +617,30 @@ class BillingInfo {
   
 };
 
+class Config;
+
+//每个线程一个，在心跳开始时tick，两次tick之间得到的快照不会改变或释放
+class ConfigCache {
+
+ public:
+   ConfigCache();
+   ~ConfigCache();
+
+ public:
+   bool init(Config* config = NULL); //默认为g_config
+   void release();
+   void tick(); //切换到最新的快照
+   const config_snapshot_t* get() const;
+   const config_info_t& config_info() const;
+   uint32_t get_version() const;
+
+ private:
+   Config* config_;
+   const config_snapshot_t* snapshot_;
+   volatile uint32_t version_;
+
+};
+
 //config class
 class Config {
  
@@ -616,6 +670,11 @@ class Config {
    void load_copy_scene_info();
    int16_t get_server_id_by_scene_id(int16_t id) const;
    int16_t get_server_id_by_share_memory_key(uint32_t key) const;
+   //其他线程只通过快照读取可以重新载入的配置，不直接读config_info_
+   const config_snapshot_t* get_snapshot() const;
+   uint32_t get_version() const;
+   bool register_cache(ConfigCache* cache);
+   void unregister_cache(ConfigCache* cache);
 
  private:
    void load_config_info_only();
@@ -636,6 +695,15 @@ class Config {
    void load_scene_info_reload();
    void load_copy_scene_info_only();
    void load_copy_scene_info_reload();
+   void publish(); //复制config_info_为新的快照并发布
+   void collect(); //释放所有线程缓存都已经离开的旧快照
+
+ private:
+   config_snapshot_t* volatile snapshot_;
+   std::vector<config_snapshot_t*> retired_snapshot_;
+   ConfigCache* cache_[kConfigCacheMax];
+   int32_t cache_count_;
+   pap_common_sys::ThreadLock lock_; //重新载入和注册缓存
 
 };
 //class end--
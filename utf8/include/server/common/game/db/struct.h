@@ -32,6 +32,10 @@ struct head_t {
   char flag;
   int16_t player_id;
   uint32_t save_time;
+  uint32_t version; //数据版本，写入方每次修改时递增
+  uint32_t save_version; //共享内存进程最后保存时的数据版本
+  uint32_t sequence; //顺序锁序号，奇数表示正在写入
+  uint32_t lock_contended; //加锁时发生竞争的次数
   head_t();
   ~head_t();
   void clean_up();
@@ -48,6 +52,10 @@ struct global_data_t {
   int32_t get_use_status(char type);
   uint32_t get_save_time(char type);
   void set_save_time(uint32_t time, char type);
+  uint32_t get_version(char type);
+  bool is_dirty(char type);
+  void set_save_version(uint32_t version, char type);
+  uint32_t get_lock_contended();
   uint32_t get_data(char type);
   void set_data(char type, uint32_t data);
   void init();
@@ -28,6 +28,7 @@ namespace billing_tologin { //验证服务器发送给登陆服务器
 typedef enum {
   kFirst = BILLING_TOLOGIN_PACKETID_MIN,
   kResultAuth, /*begin {*/
+  kResultAuthRpc, //带请求ID，回应kAskAuthRpc
   kLast, /* the last packetid */
   kMax = BILLING_TOLOGIN_PACKETID_MAX, /*end }*/
 } packetid_enum;
@@ -40,6 +41,7 @@ typedef enum {
   /*begin {*/
   kFirst = LOGIN_TOBILLING_PACKETID_MIN,
   kAskAuth,
+  kAskAuthRpc, //带请求ID，需要登录服务器同时更新
   kLast, /* the last packetid */
   kMax = LOGIN_TOBILLING_PACKETID_MAX,
   /*end }*/
@@ -16,6 +16,8 @@
 #include "common/net/socket/base.h"
 #include "common/net/socket/inputstream.h"
 #include "common/net/socket/outputstream.h"
+#include "server/common/net/connection/rpc.h"
+#include "server/common/net/connection/packetaudit.h"
 
 struct packet_async_t {
   pap_common_net::packet::Base* packet;
@@ -72,6 +74,8 @@ class Base {
    void set_managerid(int16_t id);
    //读取当前连接的socket对象
    pap_common_net::socket::Base* getsocket();
+   pap_common_net::socket::InputStream* get_socket_inputstream();
+   pap_common_net::socket::OutputStream* get_socket_outputstream();
    //断开网络连接
    virtual void disconnect();
    //当前连接是否有效
@@ -83,6 +87,19 @@ class Base {
    bool isdisconnect();
    void setdisconnect(bool status = true);
    virtual void resetkick();
+   //发送请求并等待回应，回应或超时时调用callback，失败返回0
+   uint32_t rpc_call(pap_common_net::packet::Base* packet,
+                     rpc_callback_function callback,
+                     void* data,
+                     uint32_t timeout = kRpcTimeoutDefault);
+   uint32_t get_rpc_count() const;
+
+ protected:
+   //消息是等待中请求的回应时调用回调，返回true表示已经处理
+   bool rpc_dispatch(pap_common_net::packet::Base* packet);
+   //统计收到的完整消息，超过阈值需要断开时返回false
+   bool audit_packet(uint16_t packetid, uint32_t size);
+   bool is_packet_throttled() const; //这个统计周期内暂停处理消息
 
  protected:
    int16_t id_;
@@ -92,6 +109,8 @@ class Base {
    pap_common_net::socket::InputStream* socket_inputstream_;
    pap_common_net::socket::OutputStream* socket_outputstream_;
    int8_t packetindex_;
+   Rpc* rpc_; //第一次发送请求时创建
+   PacketAudit* packet_audit_; //开启统计后第一次收到消息时创建
 
  private:
    bool isempty_;
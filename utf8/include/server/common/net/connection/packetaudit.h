@@ -0,0 +1,86 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id packetaudit.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-24 15:32:08
+ * @uses the packet audit of connection.
+ *       cn: 连接的消息统计，按packet_audit_time为周期统计每种消息的数量，
+ *           超过阈值时暂停处理或者断开连接，周期结束时可以写入日志。
+ *           接收消息时只在很小的固定数组中计数
+ */
+#ifndef PAP_SERVER_COMMON_NET_CONNECTION_PACKETAUDIT_H_
+#define PAP_SERVER_COMMON_NET_CONNECTION_PACKETAUDIT_H_
+
+#include "server/common/net/config.h"
+#include "server/common/base/config.h"
+
+namespace pap_server_common_net {
+
+namespace connection {
+
+const uint32_t kPacketAuditSlotMax = 32; //每条连接分开统计的消息种类，2的幂
+const uint32_t kPacketAuditDumpMax = 8; //日志中每条连接最多列出的消息种类
+
+typedef enum {
+  kPacketAuditPass = 0,
+  kPacketAuditThrottle = 1, //这个周期内不再处理这条连接的消息
+  kPacketAuditKick = 2, //断开连接
+} packet_audit_result_enum;
+
+class PacketAudit {
+
+ public:
+   typedef struct {
+     uint16_t packetid; //0为空
+     uint32_t count;
+     uint32_t size;
+   } slot_t;
+
+   typedef struct {
+     uint32_t audit_time; //统计周期(毫秒)，0为不统计
+     pap_server_common_base::packet_audit_setting_t packet_audit;
+   } setting_t;
+
+ public:
+   PacketAudit();
+   ~PacketAudit();
+
+ public:
+   //收到一条完整的消息时调用
+   packet_audit_result_enum receive(uint16_t packetid, uint32_t size);
+   bool is_throttled() const;
+   //周期结束时清零，暂停处理或者设置了dump时写入日志
+   void tick(uint32_t now, int16_t connectionid, const char* host);
+   void dump(int16_t connectionid, const char* host, uint32_t time);
+   void cleanup();
+
+ public:
+   //配置重新载入时由主线程设置，连接上只读
+   static void set_setting(
+       uint32_t audit_time,
+       const pap_server_common_base::packet_audit_setting_t &packet_audit);
+   static bool is_enable();
+
+ private:
+   slot_t* find(uint16_t packetid);
+
+ private:
+   slot_t slot_[kPacketAuditSlotMax];
+   uint32_t other_count_; //槽满以后的消息数量
+   uint32_t count_;
+   uint32_t size_;
+   uint32_t start_time_; //周期开始的时间，0为还没有开始
+   bool throttled_;
+   bool kicked_;
+   static setting_t setting_;
+
+};
+
+}; //namespace connection
+
+}; //namespace pap_server_common_net
+
+#endif //PAP_SERVER_COMMON_NET_CONNECTION_PACKETAUDIT_H_
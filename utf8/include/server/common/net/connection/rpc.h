@@ -0,0 +1,88 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id rpc.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2014-1-22 16:05:40
+ * @uses the request table of server to server connection.
+ *       cn: 服务器之间的请求表，发送请求时分配请求ID并记录回调和超时时间，
+ *           回应带着同样的ID回来时调用回调，超时或连接断开时回调的消息为NULL，
+ *           一条连接上可以同时有很多请求
+ */
+#ifndef PAP_SERVER_COMMON_NET_CONNECTION_RPC_H_
+#define PAP_SERVER_COMMON_NET_CONNECTION_RPC_H_
+
+#include "server/common/net/config.h"
+#include "common/net/packet/base.h"
+
+namespace pap_server_common_net {
+
+namespace connection {
+
+class Base;
+
+const uint32_t kRpcRequestMax = 4096; //每条连接同时存在的请求，2的幂
+const uint32_t kRpcTimeoutDefault = 10000; //默认超时(毫秒)
+//回应的请求ID带有这个标记，两边都可以发起请求而不会混淆
+const uint32_t kRpcResponseFlag = 0x80000000;
+
+//packet为NULL表示超时或者连接断开，回调中不要删除packet
+typedef void (*rpc_callback_function)(Base* connection,
+                                      uint32_t requestid,
+                                      pap_common_net::packet::Base* packet,
+                                      void* data);
+
+class Rpc {
+
+ public:
+   typedef struct {
+     uint32_t requestid; //0为空
+     rpc_callback_function callback;
+     void* data;
+     uint32_t deadline;
+   } request_t;
+
+   typedef struct {
+     uint32_t deadline;
+     uint32_t requestid;
+   } timer_t;
+
+ public:
+   Rpc();
+   ~Rpc();
+
+ public:
+   bool init(uint32_t requestmax = kRpcRequestMax);
+   //记录请求，满了返回0
+   uint32_t add(rpc_callback_function callback, void* data, uint32_t deadline);
+   void remove(uint32_t requestid);
+   //回应到达，没有对应的请求（已经超时）返回false
+   bool complete(Base* connection, pap_common_net::packet::Base* packet);
+   //超时的请求回调，返回超时的数量
+   uint32_t expire(Base* connection, uint32_t now);
+   void cancel(Base* connection); //连接断开时所有请求失败
+   uint32_t get_count() const;
+
+ private:
+   request_t* find(uint32_t requestid);
+   void release(request_t* request);
+   void compact(); //完成的请求在堆里太多时清理
+
+ private:
+   request_t* request_;
+   uint32_t* free_; //空位栈
+   uint32_t free_number_;
+   uint32_t mask_;
+   uint32_t shift_; //请求ID为 序号 << shift_ | 位置，不超过31位
+   uint32_t serial_;
+   std::vector<timer_t> timer_; //按超时时间的最小堆，完成的请求出堆时跳过
+
+};
+
+}; //namespace connection
+
+}; //namespace pap_server_common_net
+
+#endif //PAP_SERVER_COMMON_NET_CONNECTION_RPC_H_
@@ -28,7 +28,7 @@ namespace billing_tologin {
 class ResultAuth : public pap_common_net::packet::Base {
 
  public:
-   ResultAuth();
+   explicit ResultAuth(bool withrequest = false);
    virtual ~ResultAuth() {};
 
  public:  
@@ -37,6 +37,8 @@ class ResultAuth : public pap_common_net::packet::Base {
    virtual uint32_t execute(connection::Base* connection);
    virtual uint16_t getid() const;
    virtual uint32_t getsize() const;
+   virtual uint32_t get_requestid() const;
+   virtual void set_requestid(uint32_t requestid);
    
  public: 
    void get_account(char* buffer, uint16_t length);
@@ -80,6 +82,8 @@ class ResultAuth : public pap_common_net::packet::Base {
    char ismac_bind_; //是否密保绑定
    char is_realname_bind_; //是否实名绑定
    char is_inputname_bind_; //是否输入实名
+   uint32_t requestid_; //对应请求的ID，带有kRpcResponseFlag
+   bool withrequest_; //为真时使用kResultAuthRpc并带请求ID
 
 };
 
@@ -92,6 +96,16 @@ class ResultAuthFactory : public pap_common_net::packet::Factory {
 
 };
 
+//回应kAskAuthRpc，旧的登录服务器收不到这个消息
+class ResultAuthRpcFactory : public pap_common_net::packet::Factory {
+
+ public:
+   pap_common_net::packet::Base* createpacket();
+   uint16_t get_packetid() const;
+   uint32_t get_packet_maxsize() const;
+
+};
+
 class ResultAuthHandler {
 
  public:
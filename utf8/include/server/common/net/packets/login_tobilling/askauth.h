@@ -16,7 +16,7 @@ namespace login_tobilling {
   class AskAuth : public pap_common_net::packet::Base {
  
  public:
-   AskAuth();
+   explicit AskAuth(bool withrequest = false);
    virtual ~AskAuth(){};
 
  public:
@@ -25,6 +25,8 @@ namespace login_tobilling {
    virtual uint32_t execute(connection::Base* connection);
    virtual uint16_t getid() const;
    virtual uint32_t getsize() const;
+   virtual uint32_t get_requestid() const;
+   virtual void set_requestid(uint32_t requestid);
 
  public:
    void getaccount(char* buffer, uint8_t length) const;
@@ -54,6 +56,8 @@ namespace login_tobilling {
    char all_mibao_value[pap_common_game::define::size::mibao::kUnitNumber]
      [pap_common_game::define::size::mibao::kUnitValueLength + 1];
    char macaddress_[MD5SIZE_MAX + 1];
+   uint32_t requestid_; //回应时原样带回
+   bool withrequest_; //为真时使用kAskAuthRpc并带请求ID
 
 };
 
@@ -64,6 +68,16 @@ namespace login_tobilling {
    uint16_t get_packetid() const;
    uint32_t get_packet_maxsize() const;
 
+};
+
+  //新的登录服务器使用，旧的登录服务器仍然发送kAskAuth
+  class AskAuthRpcFactory : public pap_common_net::packet::Factory {
+
+ public:
+   pap_common_net::packet::Base* createpacket();
+   uint16_t get_packetid() const;
+   uint32_t get_packet_maxsize() const;
+
 };
 
 class AskAuthHandler {
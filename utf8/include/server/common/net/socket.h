@@ -19,9 +19,11 @@ class Socket {
 
  public:
    Socket(uint16_t port, uint32_t backlog = 5);
+   Socket(); //不创建句柄，用attach使用已经在侦听的句柄
    ~Socket();
 
  public:
+   bool attach(int32_t socketid);
    void close();
    bool accept(pap_common_net::socket::Base* socket);
    uint32_t getlinger() const;
@@ -25,10 +25,16 @@ const uint8_t kObjMax = 20;
 extern uint32_t lock_times; //内存锁定的时间
 extern bool lock_time_enable; //共享内存是否有时间锁的限制
 #endif
+extern int32_t backend_type; //共享内存的实现方式，见backend_enum
+extern bool huge_page_enable; //文件映射时是否使用大页
+extern char mmap_file_path[FILENAME_MAX]; //文件映射的目录
+extern char snapshot_path[FILENAME_MAX]; //快照文件的目录，不要放在tmpfs上
 struct data_header_t {
   uint64_t key;
   uint32_t size;
   uint32_t version;
+  uint32_t checksum; //快照时数据区的校验和
+  uint32_t snapshot_version; //快照版本，每次快照递增
   data_header_t();
   ~data_header_t();
 };
@@ -39,6 +45,11 @@ typedef enum {
   kSmptServer,
 } pool_type_enum;
 
+typedef enum {
+  kBackendSystemV = 0, //shmget/shmat
+  kBackendMmapFile = 1, //文件映射，进程崩溃后数据仍在文件中
+} backend_enum;
+
 typedef enum {
   kUseFree = 0,
   kUseReadyFree = 1,
@@ -74,6 +85,15 @@ char* map(HANDLE handle);
 #endif
 void unmap(char* pointer);
 
+#if defined(__LINUX__)
+int32_t mmap_create(uint64_t key, uint32_t size);
+int32_t mmap_open(uint64_t key, uint32_t size);
+void mmap_close(int32_t handle, uint64_t key);
+char* mmap_map(int32_t handle, uint32_t size);
+void mmap_unmap(char* pointer, uint32_t size);
+bool mmap_sync(char* pointer, uint32_t size);
+#endif
+
 }; //namespace api
 
 class Base {
@@ -90,11 +110,22 @@ class Base {
    char* get_data_pointer();
    char* get_data(uint32_t size, uint32_t index);
    uint32_t get_size();
-   bool dump(const char* filename);
+   //data为数据区的一致副本，为空时直接写共享内存中的数据
+   bool dump(const char* filename, const char* data = NULL);
+   //校验和不一致时不修改共享内存
    bool merge_from_file(const char* filename);
    void set_head_version(uint32_t version);
    uint32_t get_head_version();
+   //一致副本写入快照文件，文件映射时同时同步映射
+   bool snapshot(const char* data);
+   bool restore_snapshot();
+ private:
+   char* map(uint32_t size);
+   void get_snapshot_filename(char* filename, uint32_t length);
+
  private:
+   int32_t backend_;
+   uint64_t key_;
    uint32_t size_;
    char* data_pointer_;
    char* header_;
@@ -172,12 +203,18 @@ class UnitPool {
        ref_obj_pointer_ = NULL;
        max_size_ = 0;
        position_ = -1;
+       dirty_bits_ = NULL;
+       dirty_count_ = 0;
+       created_ = false;
+       snapshot_buffer_ = NULL;
      __LEAVE_FUNCTION
    };
    ~UnitPool() {
      __ENTER_FUNCTION
        SAFE_DELETE(ref_obj_pointer_);
        SAFE_DELETE_ARRAY(obj_);
+       SAFE_DELETE_ARRAY(dirty_bits_);
+       SAFE_DELETE_ARRAY(snapshot_buffer_);
      __LEAVE_FUNCTION
    };
    bool init(uint32_t max_count, uint64_t key, pool_type_enum pool_type) {
@@ -194,6 +231,7 @@ class UnitPool {
          result = ref_obj_pointer_->create(
              key, 
              sizeof(T) * max_count + sizeof(data_header_t));
+         created_ = result;
        }
        else if(!result) {
          return false;
@@ -221,6 +259,9 @@ class UnitPool {
            return false;
          }
        }
+       dirty_bits_ = new uint32_t[(max_size_ + 31) / 32];
+       memset(dirty_bits_, 0, sizeof(uint32_t) * ((max_size_ + 31) / 32));
+       dirty_count_ = 0;
        key_ = key;
        return true;
      __LEAVE_FUNCTION
@@ -282,6 +323,12 @@ class UnitPool {
      __LEAVE_FUNCTION
        return -1;
    };
+   bool is_created() { //共享内存是否由本次初始化新建（原有数据已丢失）
+     __ENTER_FUNCTION
+       return created_;
+     __LEAVE_FUNCTION
+       return false;
+   };
    uint64_t get_key() {
      __ENTER_FUNCTION
        return key_;
@@ -300,7 +347,7 @@ class UnitPool {
      __ENTER_FUNCTION
        Assert(ref_obj_pointer_);
        if (!ref_obj_pointer_) return false;
-       ref_obj_pointer_->merge_from_file(filename);
+       return ref_obj_pointer_->merge_from_file(filename);
      __LEAVE_FUNCTION
        return false;
    };
@@ -308,7 +355,7 @@ class UnitPool {
      __ENTER_FUNCTION
        Assert(ref_obj_pointer_);
        if (!ref_obj_pointer_) return false;
-       ref_obj_pointer_->get_head_version();
+       return ref_obj_pointer_->get_head_version();
      __LEAVE_FUNCTION
        return 0;
    };
@@ -319,6 +366,105 @@ class UnitPool {
        ref_obj_pointer_->set_head_version(version);
      __LEAVE_FUNCTION
    };
+   //逐个对象加锁复制出一致的副本，校验和与快照文件都基于这个副本
+   bool snapshot() {
+     __ENTER_FUNCTION
+       Assert(ref_obj_pointer_);
+       if (!ref_obj_pointer_ || !obj_) return false;
+       if (!snapshot_buffer_) {
+         snapshot_buffer_ = new char[sizeof(T) * max_size_];
+         Assert(snapshot_buffer_);
+       }
+       uint32_t i;
+       for (i = 0; i < max_size_; ++i) {
+         char* data = snapshot_buffer_ + sizeof(T) * i;
+         obj_[i]->lock(kFlagSelfRead); //this function must define in T*
+         memcpy(data, reinterpret_cast<const char*>(obj_[i]), sizeof(T));
+         obj_[i]->unlock(kFlagSelfRead);
+         reinterpret_cast<T*>(data)->head.flag = kFlagFree; //复制时持有的锁
+       }
+       return ref_obj_pointer_->snapshot(snapshot_buffer_);
+     __LEAVE_FUNCTION
+       return false;
+   };
+   bool restore_snapshot() {
+     __ENTER_FUNCTION
+       Assert(ref_obj_pointer_);
+       if (!ref_obj_pointer_) return false;
+       return ref_obj_pointer_->restore_snapshot();
+     __LEAVE_FUNCTION
+       return false;
+   };
+   //脏数据扫描，只比较对象头的版本号，返回需要保存的对象数量
+   uint32_t scan_dirty() {
+     __ENTER_FUNCTION
+       if (!dirty_bits_) return 0;
+       memset(dirty_bits_, 0, sizeof(uint32_t) * ((max_size_ + 31) / 32));
+       dirty_count_ = 0;
+       uint32_t i;
+       for (i = 0; i < max_size_; ++i) {
+         if (obj_[i]->is_dirty(kFlagSelfRead)) { //this function 
+                                                  //must define in T*
+           dirty_bits_[i >> 5] |= (1u << (i & 31));
+           ++dirty_count_;
+         }
+       }
+       return dirty_count_;
+     __LEAVE_FUNCTION
+       return 0;
+   };
+   bool is_dirty(uint32_t index) {
+     __ENTER_FUNCTION
+       if (!dirty_bits_ || index >= max_size_) return false;
+       return (dirty_bits_[index >> 5] & (1u << (index & 31))) != 0;
+     __LEAVE_FUNCTION
+       return false;
+   };
+   void clear_dirty(uint32_t index) {
+     __ENTER_FUNCTION
+       if (!is_dirty(index)) return;
+       dirty_bits_[index >> 5] &= ~(1u << (index & 31));
+       --dirty_count_;
+     __LEAVE_FUNCTION
+   };
+   uint64_t get_lock_contended() { //所有对象加锁竞争次数的总和
+     __ENTER_FUNCTION
+       uint64_t result = 0;
+       uint32_t i;
+       for (i = 0; i < max_size_; ++i) {
+         result += obj_[i]->get_lock_contended(); //this function 
+                                                  //must define in T*
+       }
+       return result;
+     __LEAVE_FUNCTION
+       return 0;
+   };
+   uint32_t get_dirty_count() {
+     __ENTER_FUNCTION
+       return dirty_count_;
+     __LEAVE_FUNCTION
+       return 0;
+   };
+   //从index开始找到下一个脏对象，没有则返回-1，按32位字跳过干净的区域
+   int32_t next_dirty(uint32_t index) {
+     __ENTER_FUNCTION
+       if (!dirty_bits_) return -1;
+       while (index < max_size_) {
+         uint32_t bits = dirty_bits_[index >> 5] >> (index & 31);
+         if (0 == bits) {
+           index = (index | 31) + 1;
+           continue;
+         }
+         while (0 == (bits & 1)) {
+           bits >>= 1;
+           ++index;
+         }
+         return index < max_size_ ? static_cast<int32_t>(index) : -1;
+       }
+       return -1;
+     __LEAVE_FUNCTION
+       return -1;
+   };
 
  private:
    T** obj_;
@@ -326,12 +472,30 @@ class UnitPool {
    int32_t position_;
    Base* ref_obj_pointer_;
    uint64_t key_;
+   uint32_t* dirty_bits_; //脏数据位图，每个对象一位
+   uint32_t dirty_count_;
+   bool created_;
+   char* snapshot_buffer_; //快照时的一致副本
 
 };
 
-void lock(char &flag, char type);
+uint32_t checksum(const char* data, uint32_t size);
+
+//共享内存的实现方式，所有挂接共享内存的进程在创建池之前设置
+void set_backend(int32_t type, bool huge_page, const char* path);
+void set_snapshot_path(const char* path);
+
+//flag使用原子比较交换加锁，contended不为空时记录发生竞争的次数
+void lock(char &flag, char type, uint32_t* contended = NULL);
 void unlock(char &flag, char type);
-bool trylock(char &flag, char type);
+bool trylock(char &flag, char type, uint32_t* contended = NULL);
+
+//顺序锁，写入方持有flag锁时使用write_begin/write_end包裹修改，
+//读取方不加锁，read_retry为真时需要重新读取
+uint32_t read_begin(const uint32_t &sequence);
+bool read_retry(const uint32_t &sequence, uint32_t start);
+void write_begin(uint32_t &sequence);
+void write_end(uint32_t &sequence);
 
 }; //namespace share_memory
 
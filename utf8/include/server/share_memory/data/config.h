@@ -15,6 +15,7 @@
 
 const uint32_t kServerIdleTime = 5000; //服务器停止响应时间(毫秒)
 const uint16_t kCmdSize = 256;
+const uint32_t kIntervalSaveTime = 30000; //默认的循环保存时间间隔(毫秒)
 
 typedef enum {
   kCmdUnkown,
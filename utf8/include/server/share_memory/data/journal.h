@@ -0,0 +1,97 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id journal.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2013-12-4 15:00:18
+ * @uses share memory write-ahead journal, record level deltas of one pool.
+ *       cn: 共享内存池的变化日志，每次心跳把变化的字节段批量写入并同步，
+ *           数据库保存成功后截断，-loaddump时重放。截断后每个记录第一次
+ *           变化时写整条记录，之后只写变化的字节段
+ */
+#ifndef PAP_SERVER_SHARE_MEMORY_DATA_JOURNAL_H_
+#define PAP_SERVER_SHARE_MEMORY_DATA_JOURNAL_H_
+
+#include "common/base/type.h"
+
+//"BPLJ"，记录中加了类型，旧的只有差异的日志不再重放
+const uint32_t kJournalMagic = 0x4A4C5042;
+const uint32_t kJournalBufferSize = 1024 * 1024;
+const uint32_t kJournalDiffGap = 8; //差异段之间的间隔小于此值时合并
+
+struct journal_batch_t { //一次提交的头
+  uint64_t key;
+  uint32_t magic;
+  uint32_t length; //记录的总长度，不含此头
+  uint32_t count;
+  uint32_t checksum;
+};
+
+enum journal_record_type_enum {
+  kJournalRecordDiff = 0,
+  kJournalRecordImage, //整条记录的第一段，之前的差异作废
+};
+
+struct journal_record_t { //后面紧跟size个字节
+  uint32_t type;
+  uint32_t slot;
+  uint32_t offset;
+  uint32_t size;
+};
+
+class Journal {
+
+ public:
+   Journal();
+   ~Journal();
+
+ public:
+   bool init(uint64_t key, const char* path, uint32_t slot_count);
+   bool is_imaged(uint32_t slot) const; //截断后是否已经写过整条记录
+   //整条记录从begin到end的内容加入缓冲
+   void append_image(uint32_t slot, 
+                     const char* current, 
+                     uint32_t begin, 
+                     uint32_t end);
+   //比较记录的新旧内容，从begin到end之间变化的字节段加入缓冲
+   void append_diff(uint32_t slot, 
+                    const char* current, 
+                    const char* previous,
+                    uint32_t begin,
+                    uint32_t end);
+   void append(uint32_t type,
+               uint32_t slot, 
+               uint32_t offset, 
+               const char* data, 
+               uint32_t size);
+   bool commit(); //缓冲写入文件并同步，一次心跳一次
+   bool checkpoint(); //数据已经保存到数据库，截断日志
+   bool load(); //读取所有完整的批次，用于重放
+   bool next_record(uint32_t &type,
+                    uint32_t &slot, 
+                    uint32_t &offset, 
+                    uint32_t &size, 
+                    const char* &data);
+
+ private:
+   bool open(const char* mode);
+   void close();
+
+ private:
+   uint64_t key_;
+   char filename_[FILENAME_MAX];
+   FILE* fp_;
+   char* buffer_;
+   uint32_t buffer_size_;
+   uint32_t buffer_count_;
+   char* replay_buffer_;
+   uint32_t replay_size_;
+   uint32_t replay_position_;
+   uint32_t* imaged_bits_; //每个记录一位
+   uint32_t slot_count_;
+
+};
+
+#endif //PAP_SERVER_SHARE_MEMORY_DATA_JOURNAL_H_
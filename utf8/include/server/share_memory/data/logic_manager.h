@@ -16,7 +16,11 @@
 #include "server/common/sys/share_memory.h"
 #include "server/common/base/time_manager.h"
 #include "server/common/base/log.h"
+#include "server/common/db/manager.h"
+#include "server/common/game/db/struct.h"
 #include "server/share_memory/data/config.h"
+#include "server/share_memory/data/journal.h"
+#include <vector>
 
 extern command_config_t g_command_config;
 extern bool g_clean_guild_battle;
@@ -30,26 +34,156 @@ class LogicManager {
        pool_pointer_ = NULL;
        data_ = NULL;
        last_save_time_ = 0;
+       db_manager_ = g_db_manager;
+       save_interval_ = kIntervalSaveTime;
+       journal_ = NULL;
+       shadow_ = NULL;
      __LEAVE_FUNCTION
    };
    ~LogicManager() {
-     //do nothing
+     __ENTER_FUNCTION
+       SAFE_DELETE(journal_);
+       SAFE_DELETE_ARRAY(shadow_);
+     __LEAVE_FUNCTION
    };
    bool init(pap_server_common_sys::share_memory::UnitPool<T>* pool) {
      __ENTER_FUNCTION
        if (!pool) return false;
        pool_pointer_ = pool;
        pool_pointer_->set_head_version(0);
+       //共享内存是新建的，以-loaddump启动时先从最后一次存盘后的快照恢复
+       if (kCmdModelLoadDump == g_cmd_model && pool_pointer_->is_created()) {
+         bool restored = pool_pointer_->restore_snapshot();
+         g_log->fast_save_log(kShareMemoryLogFile,
+                              "[logic manager](init) key: %"PRIu64
+                              ", restore snapshot %s",
+                              pool_pointer_->get_key(),
+                              restored ? "ok" : "failed");
+       }
        old_check_time_ = g_time_manager->get_run_time();
        old_version_ = 0;
        return true;
      __LEAVE_FUNCTION
        return false;
    };
-   bool heartbeat() {
+   //每个存储线程使用自己的数据库连接
+   void set_db_manager(pap_server_common_db::Manager* db_manager) {
+     __ENTER_FUNCTION
+       db_manager_ = db_manager;
+     __LEAVE_FUNCTION
+   };
+   void set_save_interval(uint32_t interval) {
+     __ENTER_FUNCTION
+       save_interval_ = interval;
+     __LEAVE_FUNCTION
+   };
+   //开启变化日志，共享内存是新建的并且以-loaddump启动时先重放
+   bool init_journal(const char* path) {
+     __ENTER_FUNCTION
+       using namespace pap_server_common_sys::share_memory;
+       if (!pool_pointer_) return false;
+       journal_ = new Journal();
+       Assert(journal_);
+       if (!journal_->init(pool_pointer_->get_key(), 
+                           path, 
+                           pool_pointer_->get_max_size())) {
+         SAFE_DELETE(journal_);
+         return false;
+       }
+       if (kCmdModelLoadDump == g_cmd_model && pool_pointer_->is_created()) {
+         replay_journal();
+       }
+       uint32_t max_size = pool_pointer_->get_max_size();
+       shadow_ = new char[sizeof(T) * max_size];
+       Assert(shadow_);
+       uint32_t i;
+       for (i = 0; i < max_size; ++i) {
+         T* obj = pool_pointer_->get_obj(i);
+         obj->lock(kFlagSelfRead);
+         memcpy(shadow_ + sizeof(T) * i, 
+                reinterpret_cast<const char*>(obj), 
+                sizeof(T));
+         obj->unlock(kFlagSelfRead);
+       }
+       return true;
+     __LEAVE_FUNCTION
+       return false;
+   };
+   //记录版本变化的对象除头以外的内容，截断后第一次写整条，之后写与上次
+   //副本比较变化的字节
+   bool journal() {
+     __ENTER_FUNCTION
+       using namespace pap_server_common_sys::share_memory;
+       using namespace pap_server_common_game::db::share_memory;
+       if (!journal_ || !shadow_) return false;
+       uint32_t max_size = pool_pointer_->get_max_size();
+       uint32_t i;
+       for (i = 0; i < max_size; ++i) {
+         T* obj = pool_pointer_->get_obj(i);
+         T* shadow = reinterpret_cast<T*>(shadow_ + sizeof(T) * i);
+         if (obj->get_version(kFlagSelfRead) == shadow->head.version) continue;
+         obj->lock(kFlagSelfRead);
+         const char* current = reinterpret_cast<const char*>(obj);
+         if (journal_->is_imaged(i)) {
+           journal_->append_diff(i, 
+                                 current, 
+                                 reinterpret_cast<const char*>(shadow), 
+                                 sizeof(head_t), 
+                                 sizeof(T));
+         }
+         else {
+           journal_->append_image(i, current, sizeof(head_t), sizeof(T));
+         }
+         memcpy(shadow_ + sizeof(T) * i, current, sizeof(T));
+         obj->unlock(kFlagSelfRead);
+       }
+       return journal_->commit();
+     __LEAVE_FUNCTION
+       return false;
+   };
+   //重放到快照恢复的数据上，只接受已经有整条记录的对象的差异，重放的
+   //对象不标记为脏
+   bool replay_journal() {
+     __ENTER_FUNCTION
+       using namespace pap_server_common_sys::share_memory;
+       using namespace pap_server_common_game::db::share_memory;
+       if (!journal_ || !journal_->load()) return false;
+       uint32_t max_size = pool_pointer_->get_max_size();
+       std::vector<bool> imaged(max_size, false);
+       uint32_t type;
+       uint32_t slot;
+       uint32_t offset;
+       uint32_t size;
+       const char* data;
+       uint32_t count = 0;
+       while (journal_->next_record(type, slot, offset, size, data)) {
+         if (slot >= max_size || 
+             offset < sizeof(head_t) || 
+             offset + size > sizeof(T)) {
+           continue;
+         }
+         if (kJournalRecordImage == type) imaged[slot] = true;
+         if (!imaged[slot]) continue;
+         T* obj = pool_pointer_->get_obj(slot);
+         obj->lock(kFlagSelfWrite);
+         memcpy(reinterpret_cast<char*>(obj) + offset, data, size);
+         obj->unlock(kFlagSelfWrite);
+         ++count;
+       }
+       g_log->fast_save_log(kShareMemoryLogFile, 
+                            "[logic manager](replay_journal) key: %"PRIu64
+                            ", record: %u",
+                            pool_pointer_->get_key(),
+                            count);
+       return true;
+     __LEAVE_FUNCTION
+       return false;
+   };
+   bool heartbeat(command_enum command) {
      __ENTER_FUNCTION
        uint32_t run_time = g_time_manager->get_run_time();
        bool result;
+       if (journal_) journal();
        if (run_time - old_check_time_ > kServerIdleTime) {
          old_check_time_ = run_time;
          uint32_t version = pool_pointer_->get_head_version();
@@ -65,7 +199,7 @@ class LogicManager {
          }
          old_version_ = version;
        }
-       switch(g_command_config.state.type) {
+       switch(command) {
          case kCmdSaveAll: {
            result = save_all();
            break;
@@ -98,6 +232,10 @@ class LogicManager {
    bool ready_;
    uint32_t old_version_;
    uint32_t old_check_time_;
+   pap_server_common_db::Manager* db_manager_;
+   uint32_t save_interval_;
+   Journal* journal_;
+   char* shadow_; //上次记录日志时的数据副本
 
 };
 
@@ -0,0 +1,55 @@
+/**
+ * PAP Engine ( https://github.com/viticm/pap )
+ * $Id save_thread.h
+ * @link https://github.com/viticm/pap for the canonical source repository
+ * @copyright Copyright (c) 2013-2013 viticm( viticm@126.com )
+ * @license
+ * @user viticm<viticm@126.com>
+ * @date 2013-12-3 11:32:43
+ * @uses the save thread for share memory, one thread for one pool.
+ *       cn: 每个共享内存池一个存储线程，使用各自的数据库连接和存盘间隔
+ */
+#ifndef PAP_SERVER_SHARE_MEMORY_MAIN_SAVE_THREAD_H_
+#define PAP_SERVER_SHARE_MEMORY_MAIN_SAVE_THREAD_H_
+
+#include "common/base/type.h"
+#include "common/sys/thread.h"
+#include "server/common/db/manager.h"
+#include "server/common/game/define/all.h"
+#include "server/share_memory/data/config.h"
+
+const uint32_t kSaveThreadSleepTime = 1000; //存储线程每次心跳的间隔(毫秒)
+
+class SaveThread : public pap_common_sys::Thread {
+
+ public:
+   SaveThread();
+   ~SaveThread();
+
+ public:
+   bool init(void* logic_manager, 
+             pap_server_common_game::define::type::sharememory::key_enum 
+               key_type,
+             uint32_t save_interval);
+   virtual void run();
+   virtual void stop();
+   bool is_active();
+   void post_command(command_enum command); //主线程投递命令
+   bool is_command_done(); //投递的命令是否已经执行
+
+ private:
+   bool heartbeat(command_enum command);
+   bool check_connection();
+
+ private:
+   bool active_;
+   void* logic_manager_;
+   pap_server_common_game::define::type::sharememory::key_enum key_type_;
+   pap_server_common_db::Manager* db_manager_;
+   pap_common_sys::ThreadLock lock_;
+   command_enum command_;
+   bool command_done_;
+
+};
+
+#endif //PAP_SERVER_SHARE_MEMORY_MAIN_SAVE_THREAD_H_
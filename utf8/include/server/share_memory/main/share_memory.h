@@ -15,6 +15,7 @@
 #include "server/common/game/define/all.h"
 #include "server/common/base/config.h"
 #include "server/common/sys/share_memory.h"
+#include "server/share_memory/main/save_thread.h"
 
 class ShareMemory {
 
@@ -52,11 +53,13 @@ class ShareMemory {
    bool init_staticmanager();
    bool release_staticmanager();
    bool check_worldzone_id();
+   void post_command(command_enum command); //投递给所有存储线程并等待完成
 
  private:
    pool_keydata_t keydata_pool_[pap_server_common_sys::share_memory::kObjMax];
    logicmanager_t 
        logicmanager_pool_[pap_server_common_sys::share_memory::kObjMax];
+   SaveThread* savethread_pool_[pap_server_common_sys::share_memory::kObjMax];
    bool exited_;
 
 };
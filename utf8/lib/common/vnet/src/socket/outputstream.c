@@ -191,7 +191,7 @@ bool socket_outputstream_resize(struct packet_t* packet, int32_t size) {
     memcpy(newbuffer, &buffer[headlength], bufferlength - headlength);
     memcpy(&newbuffer[bufferlength - headlength], buffer, taillength);
   }
-  SAFE_FREE(newbuffer);
+  SAFE_FREE(buffer);
   packet->buffer = newbuffer;
   packet->bufferlength = newbuffer_length;
   packet->headlength = 0;
@@ -36,6 +36,10 @@ documentation and/or software.
 /* system implementation headers */
 #include <stdio.h>
 #include <string.h>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
 
 
 // Constants for MD5Transform routine.
@@ -351,6 +355,21 @@ std::string MD5::md5() const
   return hexdigest();
 }
 
+static const char md5_hex_digits[] = "0123456789abcdef";
+
+void MD5::hexdigest(char out[33]) const
+{
+  if (!finalized) {
+    out[0] = 0;
+    return;
+  }
+  for (int i = 0; i < 16; i++) {
+    out[i * 2] = md5_hex_digits[digest[i] >> 4];
+    out[i * 2 + 1] = md5_hex_digits[digest[i] & 0xf];
+  }
+  out[32] = 0;
+}
+
 
 //////////////////////////////
 
@@ -360,4 +379,226 @@ std::ostream& operator<<(std::ostream& out, MD5 md5)
 }
 //////////////////////////////
 
+void md5_hex(const char* str, char out[kMD5HexLength + 1])
+{
+  md5_hex(str, static_cast<MD5::size_type>(strlen(str)), out);
+}
+
+void md5_hex(const char* data, 
+             MD5::size_type length, 
+             char out[kMD5HexLength + 1])
+{
+  MD5 md5;
+  md5.update(data, length);
+  md5.finalize();
+  md5.hexdigest(out);
+}
+
+//////////////////////////////
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+// the same rounds as MD5::transform, one 32 bit lane per message
+#define MD5_LANE_F(x, y, z) \
+  _mm_or_si128(_mm_and_si128(x, y), _mm_andnot_si128(x, z))
+#define MD5_LANE_G(x, y, z) \
+  _mm_or_si128(_mm_and_si128(x, z), _mm_andnot_si128(z, y))
+#define MD5_LANE_H(x, y, z) _mm_xor_si128(_mm_xor_si128(x, y), z)
+#define MD5_LANE_I(x, y, z) \
+  _mm_xor_si128(y, _mm_or_si128(x, _mm_xor_si128(z, _mm_set1_epi32(-1))))
+#define MD5_LANE_STEP(f, a, b, c, d, x, s, ac) { \
+  a = _mm_add_epi32(a, _mm_add_epi32(MD5_LANE_##f(b, c, d), \
+      _mm_add_epi32(x, _mm_set1_epi32(static_cast<int>(ac))))); \
+  a = _mm_add_epi32(_mm_or_si128(_mm_slli_epi32(a, s), \
+                                 _mm_srli_epi32(a, 32 - s)), b); \
+}
+
+static const int md5_lane_count = 4;
+
+// block number index of the padded message, zero after the last one
+static void md5_lane_block(const char* data, 
+                           MD5::size_type length, 
+                           MD5::size_type index, 
+                           unsigned char block[64])
+{
+  memset(block, 0, 64);
+  MD5::size_type begin = index * 64;
+  if (begin < length) {
+    MD5::size_type size = length - begin < 64 ? length - begin : 64;
+    memcpy(block, data + begin, size);
+  }
+  if (length >= begin && length - begin < 64)
+    block[length - begin] = 0x80;
+  MD5::size_type block_count = (length + 8) / 64 + 1;
+  if (index + 1 == block_count) {
+    unsigned int bits[2] = {length << 3, length >> 29};
+    for (int i = 0; i < 8; i++)
+      block[56 + i] = static_cast<unsigned char>(bits[i / 4] >> (i % 4 * 8));
+  }
+}
+
+static void md5_hex_lane(const char* const* data, 
+                         const MD5::size_type* length, 
+                         char (*out)[kMD5HexLength + 1])
+{
+  MD5::size_type block_count[md5_lane_count];
+  MD5::size_type block_max = 0;
+  int lane;
+  for (lane = 0; lane < md5_lane_count; lane++) {
+    block_count[lane] = (length[lane] + 8) / 64 + 1;
+    if (block_count[lane] > block_max) block_max = block_count[lane];
+  }
+  __m128i state[4];
+  state[0] = _mm_set1_epi32(0x67452301);
+  state[1] = _mm_set1_epi32(static_cast<int>(0xefcdab89));
+  state[2] = _mm_set1_epi32(static_cast<int>(0x98badcfe));
+  state[3] = _mm_set1_epi32(0x10325476);
+  for (MD5::size_type index = 0; index < block_max; index++) {
+    unsigned int block[md5_lane_count][16]; // x86 is little endian
+    int active[md5_lane_count];
+    for (lane = 0; lane < md5_lane_count; lane++) {
+      md5_lane_block(data[lane], 
+                     length[lane], 
+                     index, 
+                     reinterpret_cast<unsigned char*>(block[lane]));
+      active[lane] = index < block_count[lane] ? -1 : 0;
+    }
+    __m128i x[16];
+    for (int i = 0; i < 16; i++) {
+      x[i] = _mm_set_epi32(static_cast<int>(block[3][i]), 
+                           static_cast<int>(block[2][i]),
+                           static_cast<int>(block[1][i]), 
+                           static_cast<int>(block[0][i]));
+    }
+    __m128i a = state[0], b = state[1], c = state[2], d = state[3];
+
+    MD5_LANE_STEP(F, a, b, c, d, x[ 0], S11, 0xd76aa478);
+    MD5_LANE_STEP(F, d, a, b, c, x[ 1], S12, 0xe8c7b756);
+    MD5_LANE_STEP(F, c, d, a, b, x[ 2], S13, 0x242070db);
+    MD5_LANE_STEP(F, b, c, d, a, x[ 3], S14, 0xc1bdceee);
+    MD5_LANE_STEP(F, a, b, c, d, x[ 4], S11, 0xf57c0faf);
+    MD5_LANE_STEP(F, d, a, b, c, x[ 5], S12, 0x4787c62a);
+    MD5_LANE_STEP(F, c, d, a, b, x[ 6], S13, 0xa8304613);
+    MD5_LANE_STEP(F, b, c, d, a, x[ 7], S14, 0xfd469501);
+    MD5_LANE_STEP(F, a, b, c, d, x[ 8], S11, 0x698098d8);
+    MD5_LANE_STEP(F, d, a, b, c, x[ 9], S12, 0x8b44f7af);
+    MD5_LANE_STEP(F, c, d, a, b, x[10], S13, 0xffff5bb1);
+    MD5_LANE_STEP(F, b, c, d, a, x[11], S14, 0x895cd7be);
+    MD5_LANE_STEP(F, a, b, c, d, x[12], S11, 0x6b901122);
+    MD5_LANE_STEP(F, d, a, b, c, x[13], S12, 0xfd987193);
+    MD5_LANE_STEP(F, c, d, a, b, x[14], S13, 0xa679438e);
+    MD5_LANE_STEP(F, b, c, d, a, x[15], S14, 0x49b40821);
+    MD5_LANE_STEP(G, a, b, c, d, x[ 1], S21, 0xf61e2562);
+    MD5_LANE_STEP(G, d, a, b, c, x[ 6], S22, 0xc040b340);
+    MD5_LANE_STEP(G, c, d, a, b, x[11], S23, 0x265e5a51);
+    MD5_LANE_STEP(G, b, c, d, a, x[ 0], S24, 0xe9b6c7aa);
+    MD5_LANE_STEP(G, a, b, c, d, x[ 5], S21, 0xd62f105d);
+    MD5_LANE_STEP(G, d, a, b, c, x[10], S22, 0x2441453);
+    MD5_LANE_STEP(G, c, d, a, b, x[15], S23, 0xd8a1e681);
+    MD5_LANE_STEP(G, b, c, d, a, x[ 4], S24, 0xe7d3fbc8);
+    MD5_LANE_STEP(G, a, b, c, d, x[ 9], S21, 0x21e1cde6);
+    MD5_LANE_STEP(G, d, a, b, c, x[14], S22, 0xc33707d6);
+    MD5_LANE_STEP(G, c, d, a, b, x[ 3], S23, 0xf4d50d87);
+    MD5_LANE_STEP(G, b, c, d, a, x[ 8], S24, 0x455a14ed);
+    MD5_LANE_STEP(G, a, b, c, d, x[13], S21, 0xa9e3e905);
+    MD5_LANE_STEP(G, d, a, b, c, x[ 2], S22, 0xfcefa3f8);
+    MD5_LANE_STEP(G, c, d, a, b, x[ 7], S23, 0x676f02d9);
+    MD5_LANE_STEP(G, b, c, d, a, x[12], S24, 0x8d2a4c8a);
+    MD5_LANE_STEP(H, a, b, c, d, x[ 5], S31, 0xfffa3942);
+    MD5_LANE_STEP(H, d, a, b, c, x[ 8], S32, 0x8771f681);
+    MD5_LANE_STEP(H, c, d, a, b, x[11], S33, 0x6d9d6122);
+    MD5_LANE_STEP(H, b, c, d, a, x[14], S34, 0xfde5380c);
+    MD5_LANE_STEP(H, a, b, c, d, x[ 1], S31, 0xa4beea44);
+    MD5_LANE_STEP(H, d, a, b, c, x[ 4], S32, 0x4bdecfa9);
+    MD5_LANE_STEP(H, c, d, a, b, x[ 7], S33, 0xf6bb4b60);
+    MD5_LANE_STEP(H, b, c, d, a, x[10], S34, 0xbebfbc70);
+    MD5_LANE_STEP(H, a, b, c, d, x[13], S31, 0x289b7ec6);
+    MD5_LANE_STEP(H, d, a, b, c, x[ 0], S32, 0xeaa127fa);
+    MD5_LANE_STEP(H, c, d, a, b, x[ 3], S33, 0xd4ef3085);
+    MD5_LANE_STEP(H, b, c, d, a, x[ 6], S34, 0x4881d05);
+    MD5_LANE_STEP(H, a, b, c, d, x[ 9], S31, 0xd9d4d039);
+    MD5_LANE_STEP(H, d, a, b, c, x[12], S32, 0xe6db99e5);
+    MD5_LANE_STEP(H, c, d, a, b, x[15], S33, 0x1fa27cf8);
+    MD5_LANE_STEP(H, b, c, d, a, x[ 2], S34, 0xc4ac5665);
+    MD5_LANE_STEP(I, a, b, c, d, x[ 0], S41, 0xf4292244);
+    MD5_LANE_STEP(I, d, a, b, c, x[ 7], S42, 0x432aff97);
+    MD5_LANE_STEP(I, c, d, a, b, x[14], S43, 0xab9423a7);
+    MD5_LANE_STEP(I, b, c, d, a, x[ 5], S44, 0xfc93a039);
+    MD5_LANE_STEP(I, a, b, c, d, x[12], S41, 0x655b59c3);
+    MD5_LANE_STEP(I, d, a, b, c, x[ 3], S42, 0x8f0ccc92);
+    MD5_LANE_STEP(I, c, d, a, b, x[10], S43, 0xffeff47d);
+    MD5_LANE_STEP(I, b, c, d, a, x[ 1], S44, 0x85845dd1);
+    MD5_LANE_STEP(I, a, b, c, d, x[ 8], S41, 0x6fa87e4f);
+    MD5_LANE_STEP(I, d, a, b, c, x[15], S42, 0xfe2ce6e0);
+    MD5_LANE_STEP(I, c, d, a, b, x[ 6], S43, 0xa3014314);
+    MD5_LANE_STEP(I, b, c, d, a, x[13], S44, 0x4e0811a1);
+    MD5_LANE_STEP(I, a, b, c, d, x[ 4], S41, 0xf7537e82);
+    MD5_LANE_STEP(I, d, a, b, c, x[11], S42, 0xbd3af235);
+    MD5_LANE_STEP(I, c, d, a, b, x[ 2], S43, 0x2ad7d2bb);
+    MD5_LANE_STEP(I, b, c, d, a, x[ 9], S44, 0xeb86d391);
+
+    // lanes that already finished keep their state
+    __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(active));
+    state[0] = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(state[0], a)),
+                            _mm_andnot_si128(mask, state[0]));
+    state[1] = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(state[1], b)),
+                            _mm_andnot_si128(mask, state[1]));
+    state[2] = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(state[2], c)),
+                            _mm_andnot_si128(mask, state[2]));
+    state[3] = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(state[3], d)),
+                            _mm_andnot_si128(mask, state[3]));
+  }
+  unsigned int digest[4][md5_lane_count];
+  for (int i = 0; i < 4; i++)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digest[i]), state[i]);
+  for (lane = 0; lane < md5_lane_count; lane++) {
+    for (int i = 0; i < 16; i++) {
+      unsigned char value = 
+        static_cast<unsigned char>(digest[i / 4][lane] >> (i % 4 * 8));
+      out[lane][i * 2] = md5_hex_digits[value >> 4];
+      out[lane][i * 2 + 1] = md5_hex_digits[value & 0xf];
+    }
+    out[lane][32] = 0;
+  }
+}
+
+#undef MD5_LANE_F
+#undef MD5_LANE_G
+#undef MD5_LANE_H
+#undef MD5_LANE_I
+#undef MD5_LANE_STEP
+
+#endif
+
+void md5_hex_multi(const char* const* data, 
+                   const MD5::size_type* length, 
+                   char (*out)[kMD5HexLength + 1], 
+                   int count)
+{
+  int i = 0;
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  for (; i + md5_lane_count <= count; i += md5_lane_count)
+    md5_hex_lane(data + i, length + i, out + i);
+  if (count - i > 1) { // fill the rest lanes with the last input
+    const char* lane_data[md5_lane_count];
+    MD5::size_type lane_length[md5_lane_count];
+    char lane_out[md5_lane_count][kMD5HexLength + 1];
+    for (int lane = 0; lane < md5_lane_count; lane++) {
+      int j = i + lane < count ? i + lane : count - 1;
+      lane_data[lane] = data[j];
+      lane_length[lane] = length[j];
+    }
+    md5_hex_lane(lane_data, lane_length, lane_out);
+    for (int lane = 0; i < count; i++, lane++)
+      memcpy(out[i], lane_out[lane], kMD5HexLength + 1);
+  }
+#endif
+  for (; i < count; i++)
+    md5_hex(data[i], length[i], out[i]);
+}
+
+//////////////////////////////
+
 } //namespace pap_common_base
@@ -1,5 +1,12 @@
 #include "common/base/string.h"
 #include <limits>
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__WINDOWS__)
+#include <intrin.h>
+#endif
 
 namespace pap_common_base {
 
@@ -157,17 +164,80 @@ uint32_t crc(const char* str) {
 }
 
 /*string table {*/
+//FNV-1a7λΪֽڣλ
+static uint32_t table_hash(const char* str, uint32_t &length) {
+  uint32_t hash = 2166136261U;
+  register const char* current = str;
+  while (*current) {
+    hash ^= static_cast<unsigned char>(*current);
+    hash *= 16777619U;
+    ++current;
+  }
+  length = static_cast<uint32_t>(current - str);
+  return hash ^ (hash >> 15);
+}
+
+//һֽеvalueλ
+static uint32_t table_group_match(const int8_t* control, int8_t value) {
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+  return static_cast<uint32_t>(
+      _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value))));
+#else
+  uint32_t mask = 0;
+  uint32_t i;
+  for (i = 0; i < kTableGroupSize; ++i) {
+    if (control[i] == value) mask |= 1 << i;
+  }
+  return mask;
+#endif
+}
+
+//һֽпջɾλãλΪ1
+static uint32_t table_group_free(const int8_t* control) {
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+  return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+  uint32_t mask = 0;
+  uint32_t i;
+  for (i = 0; i < kTableGroupSize; ++i) {
+    if (control[i] < 0) mask |= 1 << i;
+  }
+  return mask;
+#endif
+}
+
+static uint32_t table_lowest_bit(uint32_t mask) {
+#if defined(__WINDOWS__)
+  unsigned long position;
+  _BitScanForward(&position, mask);
+  return static_cast<uint32_t>(position);
+#else
+  return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
 Table::Table() {
   __ENTER_FUNCTION
+    control_ = NULL;
     item_ = NULL;
+    capacity_ = 0;
+    group_mask_ = 0;
+    itemmax_ = 0;
     count_ = 0;
     size_ = 0;
+    item_size_ = 0;
   __LEAVE_FUNCTION
 }
 
 Table::~Table() {
   __ENTER_FUNCTION
+    SAFE_DELETE_ARRAY(control_);
     SAFE_DELETE_ARRAY(item_);
+    capacity_ = 0;
     count_ = 0;
     size_ = 0;
   __LEAVE_FUNCTION
@@ -175,41 +245,58 @@ Table::~Table() {
 
 void Table::init(uint32_t itemmax, uint32_t size) {
   __ENTER_FUNCTION
-    count_ = itemmax;
-    size_ = size;
+    Assert(itemmax > 0 && size > 1);
+    SAFE_DELETE_ARRAY(control_);
     SAFE_DELETE_ARRAY(item_);
-    item_ = new tableitem_t[count_];
+    //ز7/8ȡ2
+    uint32_t group_count = 1;
+    while (group_count * kTableGroupSize * 7 < itemmax * 8) group_count <<= 1;
+    capacity_ = group_count * kTableGroupSize;
+    group_mask_ = group_count - 1;
+    itemmax_ = itemmax;
+    size_ = size;
+    item_size_ = sizeof(tableitem_t) + size_;
+    item_size_ = (item_size_ + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    control_ = new int8_t[capacity_];
+    Assert(control_);
+    item_ = new char[capacity_ * item_size_];
     Assert(item_);
-    uint32_t i;
-    for (i = 0; i < count_; ++i) {
-      item_[i].str = new char[size_];
-      memset(item_[i].str, 0, sizeof(char) * size_);
-      item_[i].pointer = NULL;
-      item_[i].status = kEmpty;
-    }
+    cleanup();
   __LEAVE_FUNCTION
 }
 
 bool Table::add(const char* str, void* pointer) {
   __ENTER_FUNCTION
-    uint32_t id = crc(str);
-    uint32_t count = (id / 4) % count_;
-    uint32_t i;
-    for (i = 0; i < count_; ++i) {
-      if (kUse == item_[count].status) {
-        ++count;
-        if (count > count_) count = 0;
-        continue;
-      }
-      if (NULL == item_[count].str) {
-        item_[count].str = new char[size_];
-      }
-      memset(item_[count].str, 0, sizeof(char) * size_);
-      strncpy(item_[count].str, str, size_ - 1);
-      item_[count].pointer = pointer;
-      item_[count].status = kSet;
+    if (NULL == control_ || NULL == str || 0 == str[0]) return false;
+    uint32_t length = 0;
+    uint32_t hash = table_hash(str, length);
+    if (length >= size_) return false; //ضϣ֮鲻
+    int32_t position = find(str, hash);
+    if (position >= 0) {
+      get_item(position)->pointer = pointer;
       return true;
     }
+    if (count_ >= itemmax_) return false;
+    uint32_t group = (hash >> 7) & group_mask_;
+    uint32_t step = 0;
+    while (step <= group_mask_) {
+      int8_t* control = control_ + group * kTableGroupSize;
+      uint32_t mask = table_group_free(control);
+      if (mask != 0) {
+        uint32_t index = table_lowest_bit(mask);
+        control[index] = static_cast<int8_t>(hash & 0x7f);
+        tableitem_t* item = get_item(group * kTableGroupSize + index);
+        item->hash = hash;
+        item->pointer = pointer;
+        memcpy(reinterpret_cast<char*>(item) + sizeof(tableitem_t), 
+               str, 
+               length + 1);
+        ++count_;
+        return true;
+      }
+      ++step;
+      group = (group + step) & group_mask_; //̽⣬ᾭ
+    }
     return false;
   __LEAVE_FUNCTION
     return false;
@@ -217,74 +304,100 @@ bool Table::add(const char* str, void* pointer) {
 
 void* Table::get(const char* str) {
   __ENTER_FUNCTION
-    if(NULL == str || 0 == str[0]) return NULL;
-    uint32_t id = crc(str);
-    uint32_t count = (id / 4) % count_;
-    uint32_t i;
-    for (i = 0; i < count_; ++i) {
-      if(kEmpty == item_[count].status) return NULL;
-      if (kUse == item_[count].status) {
-        ++count;
-        if (count > count_) count = 0;
-        continue;
-      }
-      if(0 == strcmp(item_[count].str, str)) return item_[count].pointer;
-    }
+    if (NULL == control_ || NULL == str || 0 == str[0]) return NULL;
+    uint32_t length = 0;
+    uint32_t hash = table_hash(str, length);
+    if (length >= size_) return NULL;
+    int32_t position = find(str, hash);
+    if (position < 0) return NULL;
+    return get_item(position)->pointer;
   __LEAVE_FUNCTION
     return NULL;
 }
 
 void Table::remove(const char* str) {
   __ENTER_FUNCTION
-    uint32_t id = crc(str);
-    uint32_t count = (id / 4) % count_;
-    uint32_t i;
-    for (i = 0; i < count_; ++i) {
-      if(kEmpty == item_[count].status) return;
-      if (kUse == item_[count].status) {
-        ++count;
-        if (count > count_ ) count = 0;
-        continue;
-      }
-      if (0 == strcmp(item_[count].str, str)) {
-        memset(item_[count].str, 0, sizeof(char) * size_);
-        item_[count].pointer = NULL;
-        item_[count].status = kUse;
-        return;
-      }
-      ++count;
-      if (count > count_) count = 0;
-    }
+    if (NULL == control_ || NULL == str || 0 == str[0]) return;
+    uint32_t length = 0;
+    uint32_t hash = table_hash(str, length);
+    if (length >= size_) return;
+    int32_t position = find(str, hash);
+    if (position >= 0) erase(position);
   __LEAVE_FUNCTION
 }
 
 void Table::cleanup() {
   __ENTER_FUNCTION
-    if(NULL == item_) return;
-    uint32_t i;
-    for (i = 0; i < count_; ++i) {
-      memset(item_[i].str, 0, sizeof(char) * size_);
-      item_[i].pointer = NULL;
-      item_[i].status = kEmpty;
-    }
+    if (NULL == control_) return;
+    memset(control_, kEmpty, sizeof(int8_t) * capacity_);
+    memset(item_, 0, capacity_ * item_size_);
+    count_ = 0;
   __LEAVE_FUNCTION
 }
 
 void* Table::get_byposition(uint32_t position) {
   __ENTER_FUNCTION
-    if (position > count_) return NULL;
-    if (item_[position].status != kSet) return NULL;
-    return item_[position].pointer;
+    if (position >= capacity_ || control_[position] < 0) return NULL;
+    return get_item(position)->pointer;
   __LEAVE_FUNCTION
     return NULL;
 }
 
 void Table::remove_byposition(uint32_t position) {
   __ENTER_FUNCTION
-    if (position > count_) return;
-    memset(item_[position].str, 0, sizeof(char) * size_);
-    item_[position].pointer = NULL;
-    item_[position].status = kUse;
+    if (position >= capacity_ || control_[position] < 0) return;
+    erase(position);
+  __LEAVE_FUNCTION
+}
+
+uint32_t Table::get_capacity() const {
+  return capacity_;
+}
+
+uint32_t Table::get_count() const {
+  return count_;
+}
+
+tableitem_t* Table::get_item(uint32_t position) const {
+  return reinterpret_cast<tableitem_t*>(item_ + position * item_size_);
+}
+
+int32_t Table::find(const char* str, uint32_t hash) const {
+  __ENTER_FUNCTION
+    int8_t tag = static_cast<int8_t>(hash & 0x7f);
+    uint32_t group = (hash >> 7) & group_mask_;
+    uint32_t step = 0;
+    while (step <= group_mask_) {
+      const int8_t* control = control_ + group * kTableGroupSize;
+      uint32_t mask = table_group_match(control, tag);
+      while (mask != 0) {
+        uint32_t position = group * kTableGroupSize + table_lowest_bit(mask);
+        const tableitem_t* item = get_item(position);
+        if (item->hash == hash && 
+            0 == strcmp(reinterpret_cast<const char*>(item) + 
+                        sizeof(tableitem_t), str)) {
+          return static_cast<int32_t>(position);
+        }
+        mask &= mask - 1;
+      }
+      //пλ˵̽
+      if (table_group_match(control, kEmpty) != 0) return -1;
+      ++step;
+      group = (group + step) & group_mask_;
+    }
+    return -1;
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+void Table::erase(uint32_t position) {
+  __ENTER_FUNCTION
+    int8_t* control = control_ + (position & ~(kTableGroupSize - 1));
+    //ﻹпλʱû̽һ飬ֱÿ
+    control_[position] = 
+      table_group_match(control, kEmpty) != 0 ? kEmpty : kDeleted;
+    memset(get_item(position), 0, item_size_);
+    --count_;
   __LEAVE_FUNCTION
 }
 /*string table }*/
@@ -1,10 +1,202 @@
 #include "common/base/util.h" //无论如何都是用全路径
 #include "common/lib/iconv/iconv.h"
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
 
 namespace pap_common_base {
 
 namespace util {
 
+//-- charset helpers
+typedef enum {
+  kCharsetOther = 0,
+  kCharsetAscii = 1, //兼容ASCII
+  kCharsetGBK = 2,
+  kCharsetUTF8 = 3,
+} charset_type_enum;
+
+const int32_t kCharsetCacheMax = 8;
+const int32_t kCharsetNameMax = 32;
+const uint8_t kGbkLeadMin = 0x81;
+const uint8_t kGbkLeadMax = 0xFE;
+const uint8_t kGbkTrailMin = 0x40;
+const uint8_t kGbkTrailMax = 0xFE;
+const int32_t kGbkTrailCount = kGbkTrailMax - kGbkTrailMin + 1;
+const int32_t kGbkCodeCount = (kGbkLeadMax - kGbkLeadMin + 1) * kGbkTrailCount;
+
+typedef struct {
+  char from[kCharsetNameMax];
+  char to[kCharsetNameMax];
+  CharsetConverter converter;
+} charset_cache_item_t;
+
+typedef struct {
+  int32_t count;
+  charset_cache_item_t item[kCharsetCacheMax];
+} charset_cache_t;
+
+typedef struct {
+  uint16_t gbk_unicode[kGbkCodeCount]; //(首字节-0x81)*191+(尾字节-0x40)
+  uint16_t unicode_gbk[0x10000]; //首字节在高8位，0为不能转换
+} gbk_table_t;
+
+static gbk_table_t* volatile g_gbk_table = NULL;
+
+static bool charset_name_equal(const char* name, const char* compare) {
+  for (; *name && *compare; ++name, ++compare) {
+    char a = *name >= 'a' && *name <= 'z' ? *name - 'a' + 'A' : *name;
+    if (a != *compare) return false;
+  }
+  return *name == *compare;
+}
+
+static int32_t get_charset_type(const char* name) {
+  if (NULL == name) return kCharsetOther;
+  if (charset_name_equal(name, "GBK") || charset_name_equal(name, "CP936")) {
+    return kCharsetGBK;
+  }
+  if (charset_name_equal(name, "UTF-8") || charset_name_equal(name, "UTF8")) {
+    return kCharsetUTF8;
+  }
+  if (charset_name_equal(name, "GB2312") || 
+      charset_name_equal(name, "GB18030") ||
+      charset_name_equal(name, "BIG5") ||
+      charset_name_equal(name, "ASCII") ||
+      charset_name_equal(name, "ISO-8859-1")) {
+    return kCharsetAscii;
+  }
+  return kCharsetOther;
+}
+
+#if defined(__LINUX__)
+static pthread_key_t g_charset_cache_key;
+static pthread_once_t g_charset_cache_once = PTHREAD_ONCE_INIT;
+
+static void charset_cache_destroy(void* cache) {
+  delete static_cast<charset_cache_t*>(cache);
+}
+
+static void charset_cache_key_create() {
+  pthread_key_create(&g_charset_cache_key, charset_cache_destroy);
+}
+#endif
+
+static charset_cache_t* get_charset_cache() {
+#if defined(__LINUX__)
+  pthread_once(&g_charset_cache_once, charset_cache_key_create);
+  charset_cache_t* cache = 
+    static_cast<charset_cache_t*>(pthread_getspecific(g_charset_cache_key));
+  if (NULL == cache) {
+    cache = new charset_cache_t;
+    cache->count = 0;
+    pthread_setspecific(g_charset_cache_key, cache);
+  }
+  return cache;
+#elif defined(__WINDOWS__)
+  static __declspec(thread) charset_cache_t* cache = NULL; //线程退出时不释放
+  if (NULL == cache) {
+    cache = new charset_cache_t;
+    cache->count = 0;
+  }
+  return cache;
+#endif
+}
+
+//UTF-8解码一个字符，返回使用的字节数，不完整返回0，非法返回-1
+static int32_t utf8_decode(const uint8_t* src, int32_t length, uint32_t &code) {
+  uint8_t first = src[0];
+  int32_t need = 0;
+  if (first < 0x80) {
+    code = first;
+    return 1;
+  }
+  else if (first >= 0xC2 && first <= 0xDF) {
+    need = 2;
+    code = first & 0x1F;
+  }
+  else if (first >= 0xE0 && first <= 0xEF) {
+    need = 3;
+    code = first & 0x0F;
+  }
+  else if (first >= 0xF0 && first <= 0xF4) {
+    need = 4;
+    code = first & 0x07;
+  }
+  else {
+    return -1;
+  }
+  int32_t i;
+  for (i = 1; i < need; ++i) {
+    if (i >= length) return 0;
+    if ((src[i] & 0xC0) != 0x80) return -1;
+    code = (code << 6) | (src[i] & 0x3F);
+  }
+  if ((3 == need && code < 0x800) || (4 == need && code < 0x10000)) {
+    return -1; //过长编码
+  }
+  return need;
+}
+
+//用iconv逐个转换所有双字节编码生成表，多个线程同时生成时只保留一个
+static const gbk_table_t* get_gbk_table() {
+  gbk_table_t* table = g_gbk_table;
+  if (table) {
+    memory_barrier();
+    return table;
+  }
+  CharsetConverter converter;
+  if (!converter.init("GBK", "UTF-8")) return NULL;
+  table = new gbk_table_t;
+  memset(table, 0, sizeof(gbk_table_t));
+  int32_t count = 0;
+  int32_t lead, trail;
+  for (lead = kGbkLeadMin; lead <= kGbkLeadMax; ++lead) {
+    for (trail = kGbkTrailMin; trail <= kGbkTrailMax; ++trail) {
+      if (0x7F == trail) continue;
+      char source[2] = {static_cast<char>(lead), static_cast<char>(trail)};
+      char result[8];
+      int32_t length = converter.convert(result, sizeof(result), source, 2);
+      uint32_t code = 0;
+      if (length < 2 || 
+          utf8_decode(reinterpret_cast<const uint8_t*>(result), 
+                      length, 
+                      code) != length ||
+          code > 0xFFFF) {
+        continue;
+      }
+      table->gbk_unicode[(lead - kGbkLeadMin) * kGbkTrailCount + 
+                         trail - kGbkTrailMin] = static_cast<uint16_t>(code);
+      if (0 == table->unicode_gbk[code]) {
+        table->unicode_gbk[code] = static_cast<uint16_t>(lead << 8 | trail);
+      }
+      ++count;
+    }
+  }
+  if (0 == count) {
+    delete table;
+    return NULL;
+  }
+  memory_barrier();
+#if defined(__LINUX__)
+  bool published = 
+    __sync_bool_compare_and_swap(&g_gbk_table, 
+                                 static_cast<gbk_table_t*>(NULL), 
+                                 table);
+#elif defined(__WINDOWS__)
+  bool published = NULL == InterlockedCompareExchangePointer(
+      reinterpret_cast<PVOID volatile*>(&g_gbk_table), table, NULL);
+#endif
+  if (!published) {
+    delete table;
+    table = g_gbk_table;
+    memory_barrier();
+  }
+  return table;
+}
+//charset helpers --
+
 char value_toascii(char in) {
   __ENTER_FUNCTION
     char out;
@@ -209,6 +401,14 @@ void sleep(uint32_t million_seconds) {
   __LEAVE_FUNCTION
 }
 
+void memory_barrier() {
+#if defined(__WINDOWS__)
+  MemoryBarrier();
+#elif defined(__LINUX__)
+  __sync_synchronize();
+#endif
+}
+
 uint32_t str_length(const char* str) {
   __ENTER_FUNCTION
     uint32_t i = 0;
@@ -248,9 +448,8 @@ void simple_encrypt_decrypt(char* str, uint32_t strlength, uint32_t key_begin) {
   __ENTER_FUNCTION
     strlength = str_length(str);
     if (0 <= strlength) return;
-    pap_common_base::MD5 str_md5(PASSWORD_ENCRYPT_KEY);
-    char key[129];
-    strncpy(key, (str_md5.md5()).c_str(), sizeof(key) - 1);
+    char key[129] = {0};
+    pap_common_base::md5_hex(PASSWORD_ENCRYPT_KEY, key);
     //swap one time
     password_swap_chars(key);
     uint32_t key_length = str_length(key);
@@ -278,65 +477,316 @@ int charset_convert(const char* from,
                     const char* src, 
                     int srclen) {
   __ENTER_FUNCTION
-    int status = 0;
-    iconv_t cd;
-    const char *inbuf  = src;
-    char *outbuf       = save;
-    size_t outbufsize  = savelen;
-    size_t savesize    = 0;
-    size_t inbufsize   = srclen;
-    const char* inptr  = inbuf;
-    size_t insize      = inbufsize;
-    char* outptr       = outbuf;
-    size_t outsize     = outbufsize;
-
-    cd = iconv_open(to, from);
-    iconv(cd, NULL, NULL, NULL, NULL);
-    if (0 == inbufsize) {
-      status = -1;
-      goto done;
+    if (NULL == save || savelen <= 0 || NULL == src || srclen <= 0) {
+      return -1;
+    }
+    int32_t from_type = get_charset_type(from);
+    int32_t to_type = get_charset_type(to);
+    //两边都兼容ASCII时，纯ASCII直接复制
+    if (from_type != kCharsetOther && 
+        to_type != kCharsetOther && 
+        is_ascii(src, srclen)) {
+      if (srclen >= savelen) return -5;
+      memcpy(save, src, srclen);
+      save[srclen] = '\0';
+      return srclen;
+    }
+    int32_t result = -1;
+    if (kCharsetGBK == from_type && kCharsetUTF8 == to_type) {
+      result = gbk_toutf8(save, savelen, src, srclen);
     }
-    while (0 < insize) {
-      size_t res = iconv(cd, (char**)&inptr, &insize, &outptr, &outsize);
-      if (outptr != outbuf) {
-        int saved_errno = errno;
-        int outsize = outptr - outbuf;
-        strncpy(save + savesize, outbuf, outsize);
-        errno = saved_errno;
-      }
-      if ((size_t)(-1) == res) {
-        if (EILSEQ == errno) {
-          int one = 1 ;
-          iconvctl(cd, ICONV_SET_DISCARD_ILSEQ, &one);
-          status = -3;
-        } 
-        else if (EINVAL == errno) {
-          if (0 == inbufsize) {
-            status = -4;
-            goto done;
-          } 
-          else {
-            break;
-          }
-        } 
-        else if (E2BIG == errno) {
-          status = -5;
-          goto done;
-        } 
-        else {
-          status = -6;
-          goto done;
+    else if (kCharsetUTF8 == from_type && kCharsetGBK == to_type) {
+      result = utf8_togbk(save, savelen, src, srclen);
+    }
+    if (result >= 0) return result;
+    CharsetConverter* converter = get_charset_converter(from, to);
+    if (NULL == converter) return -1;
+    return converter->convert(save, savelen, src, srclen);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+//crc32(0xEDB88320)的查表，常量表在多线程中使用不需要初始化
+static const uint32_t kCrc32Table[256] = {
+  0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA,
+  0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+  0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+  0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+  0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE,
+  0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+  0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC,
+  0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+  0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+  0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+  0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940,
+  0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+  0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116,
+  0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+  0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+  0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+  0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A,
+  0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+  0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818,
+  0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+  0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+  0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+  0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C,
+  0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+  0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2,
+  0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+  0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+  0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+  0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086,
+  0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+  0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4,
+  0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+  0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+  0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+  0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8,
+  0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+  0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE,
+  0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+  0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+  0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+  0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252,
+  0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+  0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60,
+  0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+  0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+  0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+  0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04,
+  0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+  0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A,
+  0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+  0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+  0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+  0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E,
+  0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+  0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C,
+  0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+  0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+  0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+  0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0,
+  0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+  0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6,
+  0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+  0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+  0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+uint32_t crc32(const char* data, uint32_t size) {
+  __ENTER_FUNCTION
+    uint32_t result = 0xFFFFFFFF;
+    uint32_t i;
+    for (i = 0; i < size; ++i) {
+      result = 
+        kCrc32Table[(result ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ 
+        (result >> 8);
+    }
+    return result ^ 0xFFFFFFFF;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+CharsetConverter::CharsetConverter() {
+  __ENTER_FUNCTION
+    handle_ = NULL;
+  __LEAVE_FUNCTION
+}
+
+CharsetConverter::~CharsetConverter() {
+  __ENTER_FUNCTION
+    if (handle_) iconv_close(static_cast<iconv_t>(handle_));
+    handle_ = NULL;
+  __LEAVE_FUNCTION
+}
+
+bool CharsetConverter::init(const char* from, const char* to) {
+  __ENTER_FUNCTION
+    if (handle_) iconv_close(static_cast<iconv_t>(handle_));
+    handle_ = NULL;
+    iconv_t cd = iconv_open(to, from);
+    if (reinterpret_cast<iconv_t>(-1) == cd) return false;
+    int one = 1;
+    iconvctl(cd, ICONV_SET_DISCARD_ILSEQ, &one);
+    handle_ = cd;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+int32_t CharsetConverter::convert(char* save, 
+                                  int32_t savelen, 
+                                  const char* src, 
+                                  int32_t srclen) {
+  __ENTER_FUNCTION
+    if (!handle_ || savelen <= 0) return -1;
+    iconv_t cd = static_cast<iconv_t>(handle_);
+    iconv(cd, NULL, NULL, NULL, NULL);
+    const char* inptr = src;
+    size_t insize = srclen;
+    char* outptr = save;
+    size_t outsize = savelen - 1; //留给结尾的0
+    while (insize > 0) {
+      size_t result = iconv(cd, (char**)&inptr, &insize, &outptr, &outsize);
+      if (static_cast<size_t>(-1) == result) {
+        if (EILSEQ == errno) { //跳过无法转换的字节
+          ++inptr;
+          --insize;
+          continue;
         }
+        if (EINVAL == errno) break; //结尾是不完整的字符
+        *outptr = '\0';
+        return -1;
       }
     }
-    status = strlen(save);
-    done:
-    iconv_close(cd);
-    return status;
+    *outptr = '\0';
+    return static_cast<int32_t>(outptr - save);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+bool is_ascii(const char* str, int32_t length) {
+  __ENTER_FUNCTION
+    register const char* current = str;
+    const char* end = str + length;
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128i high = _mm_setzero_si128();
+    while (end - current >= 16) {
+      high = _mm_or_si128(
+          high, _mm_loadu_si128(reinterpret_cast<const __m128i*>(current)));
+      current += 16;
+    }
+    if (_mm_movemask_epi8(high) != 0) return false;
+#endif
+    while (current < end) {
+      if (*current & 0x80) return false;
+      ++current;
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+int32_t gbk_toutf8(char* save, 
+                   int32_t savelen, 
+                   const char* src, 
+                   int32_t srclen) {
+  __ENTER_FUNCTION
+    const gbk_table_t* table = get_gbk_table();
+    if (NULL == table || savelen <= 0) return -1;
+    const uint8_t* current = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* end = current + srclen;
+    char* output = save;
+    char* output_end = save + savelen - 1; //留给结尾的0
+    while (current < end) {
+      uint8_t lead = *current;
+      if (lead < 0x80) {
+        if (output >= output_end) return -1;
+        *output++ = static_cast<char>(lead);
+        ++current;
+        continue;
+      }
+      if (current + 1 >= end) break; //结尾是不完整的字符
+      uint8_t trail = current[1];
+      uint32_t code = 0;
+      if (lead >= kGbkLeadMin && lead <= kGbkLeadMax && 
+          trail >= kGbkTrailMin && trail <= kGbkTrailMax) {
+        code = table->gbk_unicode[(lead - kGbkLeadMin) * kGbkTrailCount + 
+                                  trail - kGbkTrailMin];
+      }
+      if (0 == code) { //跳过无法转换的字节
+        ++current;
+        continue;
+      }
+      if (code < 0x800) {
+        if (output_end - output < 2) return -1;
+        *output++ = static_cast<char>(0xC0 | code >> 6);
+      }
+      else {
+        if (output_end - output < 3) return -1;
+        *output++ = static_cast<char>(0xE0 | code >> 12);
+        *output++ = static_cast<char>(0x80 | (code >> 6 & 0x3F));
+      }
+      *output++ = static_cast<char>(0x80 | (code & 0x3F));
+      current += 2;
+    }
+    *output = '\0';
+    return static_cast<int32_t>(output - save);
   __LEAVE_FUNCTION
     return -1;
 }
 
+int32_t utf8_togbk(char* save, 
+                   int32_t savelen, 
+                   const char* src, 
+                   int32_t srclen) {
+  __ENTER_FUNCTION
+    const gbk_table_t* table = get_gbk_table();
+    if (NULL == table || savelen <= 0) return -1;
+    const uint8_t* current = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* end = current + srclen;
+    char* output = save;
+    char* output_end = save + savelen - 1;
+    while (current < end) {
+      if (*current < 0x80) {
+        if (output >= output_end) return -1;
+        *output++ = static_cast<char>(*current);
+        ++current;
+        continue;
+      }
+      uint32_t code = 0;
+      int32_t length = 
+        utf8_decode(current, static_cast<int32_t>(end - current), code);
+      if (0 == length) break;
+      if (length < 0) {
+        ++current;
+        continue;
+      }
+      current += length;
+      uint16_t gbk = code <= 0xFFFF ? table->unicode_gbk[code] : 0;
+      if (0 == gbk) continue;
+      if (output_end - output < 2) return -1;
+      *output++ = static_cast<char>(gbk >> 8);
+      *output++ = static_cast<char>(gbk & 0xFF);
+    }
+    *output = '\0';
+    return static_cast<int32_t>(output - save);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+CharsetConverter* get_charset_converter(const char* from, const char* to) {
+  __ENTER_FUNCTION
+    if (NULL == from || NULL == to || 
+        strlen(from) >= static_cast<size_t>(kCharsetNameMax) ||
+        strlen(to) >= static_cast<size_t>(kCharsetNameMax)) {
+      return NULL;
+    }
+    charset_cache_t* cache = get_charset_cache();
+    int32_t i;
+    for (i = 0; i < cache->count; ++i) {
+      if (0 == strcmp(cache->item[i].from, from) && 
+          0 == strcmp(cache->item[i].to, to)) {
+        return &(cache->item[i].converter);
+      }
+    }
+    //满了替换最后一个
+    i = cache->count < kCharsetCacheMax ? cache->count : kCharsetCacheMax - 1;
+    charset_cache_item_t* item = &(cache->item[i]);
+    item->from[0] = '\0';
+    if (!item->converter.init(from, to)) return NULL;
+    strncpy(item->from, from, sizeof(item->from) - 1);
+    item->from[sizeof(item->from) - 1] = '\0';
+    strncpy(item->to, to, sizeof(item->to) - 1);
+    item->to[sizeof(item->to) - 1] = '\0';
+    if (cache->count < kCharsetCacheMax) ++(cache->count);
+    return &(item->converter);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
 } //namespace util
 
 } //namespace pap_common_base
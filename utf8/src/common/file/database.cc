@@ -1,8 +1,22 @@
 #include <map>
+#include <algorithm>
 #include <assert.h>
 #include <exception>
 #include "common/file/database.h"
 #include "common/base/util.h"
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__WINDOWS__)
+#include <intrin.h>
+#endif
+#if defined(__LINUX__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 namespace pap_common_file {
 
@@ -11,6 +25,12 @@ Database::Database(uint32_t id) {
     id_ = id;
     string_buffer_ = NULL;
     index_column_ = -1;
+    record_number_ = 0;
+    field_number_ = 0;
+    string_buffer_size_ = 0;
+    mapped_memory_ = NULL;
+    mapped_size_ = 0;
+    column_built_ = false;
   __LEAVE_FUNCTION
 }
 
@@ -18,6 +38,10 @@ Database::~Database() {
   __ENTER_FUNCTION
     if (string_buffer_) SAFE_DELETE_ARRAY(string_buffer_);
     string_buffer_ = NULL;
+#if defined(__LINUX__)
+    if (mapped_memory_) munmap(mapped_memory_, mapped_size_);
+#endif
+    mapped_memory_ = NULL;
   __LEAVE_FUNCTION
 }
 
@@ -26,6 +50,12 @@ bool Database::open_from_txt(const char* filename) {
     assert(filename);
     FILE* fp = fopen(filename, "rb");
     if (NULL == fp) return false;
+    uint32_t identify = 0;
+    if (1 == fread(&identify, sizeof(identify), 1, fp) && 
+        kDatabaseBinaryIdentify == identify) {
+      fclose(fp);
+      return open_from_mapping(filename);
+    }
     fseek(fp, 0, SEEK_END);
     int32_t filesize = ftell(fp);
     fseek(fp, 0, SEEK_SET);
@@ -33,6 +63,7 @@ bool Database::open_from_txt(const char* filename) {
     char* memory = new char[filesize + 1];
     memset(memory, 0, filesize + 1);
     fread(memory, 1, filesize, fp);
+    fclose(fp);
     //memory[filesize + 1] = '\0'; //记住这个错误，不要手动去改变内存数组，初始化使用memset即可
     bool result = open_from_memory(memory, memory + filesize + 1, filename);
     SAFE_DELETE_ARRAY(memory); memory = 0;
@@ -46,8 +77,9 @@ bool Database::open_from_memory(const char* memory,
                                 const char* filename) {
   __ENTER_FUNCTION
     bool result = true;
+    reset_index();
     if (end - memory >= static_cast<int32_t>(sizeof(file_head_t)) && 
-        *((uint32_t*)memory) == 0XDDBBCC0) {
+        *((uint32_t*)memory) == kDatabaseBinaryIdentify) {
       result = open_from_memory_binary(memory, end, filename);
     }
     else {
@@ -97,23 +129,17 @@ const Database::field_data* Database::search_first_column_equal(
     int32_t column, 
     const field_data &value) const {
   __ENTER_FUNCTION
-    if (column < 0 || column > field_number_) return NULL;
+    if (column < 0 || column >= field_number_) return NULL;
     field_type_enum type = type_[column];
+    if (type != kTypeFloat) { //整数和字符串列声明过哈希索引时使用索引
+      int32_t index = find_index(kIndexHash, &column, 1);
+      if (index >= 0 && index_[index].built) return search_index(index, &value);
+    }
     register int32_t i;
     for (i = 0; i < record_number_; ++i) {
       const field_data &_field_data = 
         data_buffer_[(field_number_ * i) + column];
-      bool result;
-      if (kTypeInt == type) {
-        result = field_equal(kTypeInt, _field_data, value);
-      }
-      else if (kTypeFloat == type) {
-        result = field_equal(kTypeInt, _field_data, value);
-      }
-      else {
-        result = field_equal(kTypeInt, _field_data, value);
-      }
-      if (result) {
+      if (field_equal(type, _field_data, value)) {
         return &(data_buffer_[field_number_ * i]);
       }
     }
@@ -143,6 +169,14 @@ int32_t Database::get_record_number() const {
     return -1;
 }
 
+int32_t Database::get_field_type(int32_t column) const {
+  __ENTER_FUNCTION
+    if (column < 0 || column >= field_number_) return -1;
+    return type_[column];
+  __LEAVE_FUNCTION
+    return -1;
+}
+
 void Database::create_index(int32_t column, const char* filename) {
   __ENTER_FUNCTION
     if (column < 0 || column > field_number_ || index_column_ == column) return;
@@ -258,144 +292,337 @@ bool Database::field_equal(field_type_enum type, const field_data &a, const fiel
     return false;
 }
 
+int32_t Database::field_compare(field_type_enum type, 
+                                const field_data &a, 
+                                const field_data &b) {
+  __ENTER_FUNCTION
+    int32_t result = 0;
+    if (kTypeInt == type) {
+      result = a.int_value < b.int_value ? -1 : 
+               (a.int_value > b.int_value ? 1 : 0);
+    }
+    else if (kTypeFloat == type) {
+      result = a.float_value < b.float_value ? -1 : 
+               (a.float_value > b.float_value ? 1 : 0);
+    }
+    else {
+      const char* left = a.string_value ? a.string_value : "";
+      const char* right = b.string_value ? b.string_value : "";
+      result = strcmp(left, right);
+    }
+    return result;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+//-- text parser helpers
+//找到第一个 \t \n \r \0，没有则返回end，SSE2时每次比较16个字节
+static const char* find_separator(const char* begin, const char* end) {
+  register const char* current = begin;
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i line_feed = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  const __m128i zero = _mm_setzero_si128();
+  while (end - current >= 16) {
+    __m128i chunk = 
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+    __m128i match = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), 
+                     _mm_cmpeq_epi8(chunk, line_feed)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_return), 
+                     _mm_cmpeq_epi8(chunk, zero)));
+    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+    if (mask != 0) {
+#if defined(__WINDOWS__)
+      unsigned long position;
+      _BitScanForward(&position, mask);
+      return current + position;
+#else
+      return current + __builtin_ctz(mask);
+#endif
+    }
+    current += 16;
+  }
+#endif
+  while (current < end && 
+         *current != '\t' && 
+         *current != '\n' && 
+         *current != '\r' && 
+         *current != '\0') {
+    ++current;
+  }
+  return current;
+}
+
+//与atoi相同的规则，不需要以0结尾
+static int32_t parse_int(const char* begin, const char* end) {
+  register const char* current = begin;
+  while (current < end && (' ' == *current || '\f' == *current || 
+         '\v' == *current)) {
+    ++current;
+  }
+  bool negative = false;
+  if (current < end && ('-' == *current || '+' == *current)) {
+    negative = '-' == *current;
+    ++current;
+  }
+  uint32_t value = 0;
+  while (current < end && *current >= '0' && *current <= '9') {
+    value = value * 10 + static_cast<uint32_t>(*current - '0');
+    ++current;
+  }
+  return static_cast<int32_t>(negative ? 0 - value : value);
+}
+
+//只有整数和小数部分且有效数字不超过15位时直接计算，结果与atof一致，
+//其他情况（指数、inf等）复制出来使用atof
+static float parse_float(const char* begin, const char* end) {
+  static const double kPower10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  register const char* current = begin;
+  while (current < end && ' ' == *current) ++current;
+  bool negative = false;
+  if (current < end && ('-' == *current || '+' == *current)) {
+    negative = '-' == *current;
+    ++current;
+  }
+  uint64_t mantissa = 0;
+  int32_t digits = 0;
+  int32_t fraction = 0;
+  while (current < end && *current >= '0' && *current <= '9') {
+    if (mantissa != 0 || *current != '0') ++digits;
+    mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+    ++current;
+  }
+  if (current < end && '.' == *current) {
+    ++current;
+    while (current < end && *current >= '0' && *current <= '9') {
+      if (mantissa != 0 || *current != '0') ++digits;
+      mantissa = mantissa * 10 + static_cast<uint64_t>(*current - '0');
+      ++fraction;
+      ++current;
+    }
+  }
+  bool simple = digits <= 15 && fraction <= 22 && 
+                (current == end || 
+                 (*current != 'e' && *current != 'E' && 
+                  *current != 'x' && *current != 'X' &&
+                  *current != 'i' && *current != 'I' && 
+                  *current != 'n' && *current != 'N'));
+  if (simple) {
+    double value = static_cast<double>(mantissa) / kPower10[fraction];
+    return static_cast<float>(negative ? -value : value);
+  }
+  char temp[128];
+  int32_t length = static_cast<int32_t>(end - begin);
+  if (length > static_cast<int32_t>(sizeof(temp)) - 1) {
+    length = sizeof(temp) - 1;
+  }
+  memcpy(temp, begin, length);
+  temp[length] = '\0';
+  return static_cast<float>(atof(temp));
+}
+
+static uint32_t string_hash(const char* str, int32_t length) {
+  uint32_t hash = 2166136261u; //FNV-1a
+  int32_t i;
+  for (i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+//text parser helpers --
+
 bool Database::open_from_memory_text(const char* memory, 
                                      const char* end, 
                                      const char* filename) {
   __ENTER_FUNCTION
-    char line[(1024 * 10) + 1]; //long string
-    memset(line, '\0', sizeof(line));
+    //一次遍历，列数据直接写入data_buffer_，字符串区预先分配不再增长
     register const char* _memory = memory;
-    _memory = get_line_from_memory(line, sizeof(line) - 1, _memory, end);
-    if (!_memory) return false;
-    std::vector<std::string> result;
-    convert_string_tovector(line, result, "\t", true, true);
-    if (result.empty()) return false;
+    if (_memory >= end || '\0' == *_memory) return false;
+    //header: field types
     field_type _field_type;
-    _field_type.resize(result.size());
-    int32_t i;
-    uint32_t result_size = static_cast<uint32_t>(result.size());
-    for (i = 0; i < static_cast<int32_t>(result_size); ++i) {
-      if ("INT" == result[i]) {
-        _field_type[i] = kTypeInt;
-      }
-      else if("FLOAT" == result[i]) {
-        _field_type[i] = kTypeFloat;
-      }
-      else if("STRING" == result[i]) {
-        _field_type[i] = kTypeString;
-      }
-      else {
-        return false;
+    for (;;) {
+      const char* separator = find_separator(_memory, end);
+      int32_t length = static_cast<int32_t>(separator - _memory);
+      if (length > 0) {
+        if (3 == length && 0 == memcmp(_memory, "INT", 3)) {
+          _field_type.push_back(kTypeInt);
+        }
+        else if (5 == length && 0 == memcmp(_memory, "FLOAT", 5)) {
+          _field_type.push_back(kTypeFloat);
+        }
+        else if (6 == length && 0 == memcmp(_memory, "STRING", 6)) {
+          _field_type.push_back(kTypeString);
+        }
+        else {
+          return false;
+        }
       }
+      _memory = separator;
+      if (_memory >= end || *_memory != '\t') break;
+      ++_memory;
     }
-    //init
-    int32_t record_number = 0;
+    if (_field_type.empty()) return false;
     int32_t field_number = static_cast<int32_t>(_field_type.size());
-    std::vector<std::pair<std::string, int32_t> > string_buffer; //临时字符串区
-    std::map<std::string, int32_t> map_string_buffer; //字符串map
-    _memory = get_line_from_memory(line, sizeof(line) - 1, _memory, end);
-    if (!_memory) return false;
-    int32_t string_buffer_size = 0;
-    bool loop = true;
-    do {
-      _memory = get_line_from_memory(line, sizeof(line) - 1, _memory, end);
-      if (!_memory) break;
-      if ('#' == line[0]) continue; //注释行
-      convert_string_tovector(line, result, "\t", true, false);
-      if (result.empty()) continue; //空行
-      if (static_cast<int32_t>(result.size()) != field_number) { //列数不对
-        int32_t left_number = 
-          field_number - static_cast<int32_t>(result.size());
-        for (i = 0; i < left_number; ++i) {
-          result.push_back("");
+    //skip line end and the column name line
+    while (_memory < end && ('\r' == *_memory || '\n' == *_memory)) ++_memory;
+    if (_memory >= end || '\0' == *_memory) return false;
+    while (_memory < end && *_memory != '\0' && 
+           *_memory != '\r' && *_memory != '\n') {
+      ++_memory;
+    }
+
+    //reserve
+    int32_t line_number = 1;
+    const char* line_feed = _memory;
+    while (line_feed < end && 
+           (line_feed = static_cast<const char*>(
+             memchr(line_feed, '\n', end - line_feed))) != NULL) {
+      ++line_number;
+      ++line_feed;
+    }
+    data_buffer_.clear();
+    data_buffer_.reserve(line_number * field_number);
+    std::vector<char> string_buffer; //转换后最多是原来的两倍，不会重新分配
+    string_buffer.reserve(static_cast<size_t>(end - memory) * 2 + 16);
+    string_buffer.push_back('\0'); //偏移0为空字符串
+    std::vector<int32_t> string_slot; //开放寻址，值为字符串偏移
+    string_slot.resize(1024, -1);
+    uint32_t string_count = 0;
+
+    int32_t record_number = 0;
+    int32_t i;
+    for (;;) {
+      while (_memory < end && ('\r' == *_memory || '\n' == *_memory)) {
+        ++_memory;
+      }
+      if (_memory >= end || '\0' == *_memory) break;
+      const char* separator = find_separator(_memory, end);
+      if ('#' == *_memory || separator == _memory) { //注释行或第一列为空
+        while (separator < end && '\t' == *separator) {
+          separator = find_separator(separator + 1, end);
         }
+        _memory = separator;
+        continue;
       }
-      if (result[0].empty()) continue;
+      bool line_end = false;
       for (i = 0; i < field_number; ++i) {
+        const char* cell = _memory;
+        const char* cell_end = cell;
+        if (!line_end) {
+          cell_end = i > 0 ? find_separator(cell, end) : separator;
+          _memory = cell_end;
+          if (_memory < end && '\t' == *_memory) {
+            ++_memory;
+          }
+          else {
+            line_end = true;
+          }
+        }
         field_data _field_data;
-        memset(&_field_data, 0, sizeof(_field_data));
+        _field_data.int_value = 0;
         switch(_field_type[i]) {
           case kTypeInt: {
-            _field_data.int_value = atoi(result[i].c_str());
-            data_buffer_.push_back(_field_data);
+            _field_data.int_value = parse_int(cell, cell_end);
             break;
           }
           case kTypeFloat: {
-            _field_data.float_value = static_cast<float>(atof(result[i].c_str()));
-            data_buffer_.push_back(_field_data);
+            _field_data.float_value = parse_float(cell, cell_end);
             break;
           }
           case kTypeString: {
+            int32_t length = static_cast<int32_t>(cell_end - cell);
+            if (0 == length) break;
+            int32_t offset = static_cast<int32_t>(string_buffer.size());
+            string_buffer.resize(offset + length * 2 + 1);
+            char* save = &(string_buffer[offset]);
+            int32_t save_length = -1;
 #if defined(UTF8)
-            const char* value = result[i].c_str();
-            //convert charset
-            char convert_str[513];
-            memset(convert_str, '\0', sizeof(convert_str));
-            int32_t convert_result = 
-              pap_common_base::util::charset_convert("GBK",
-                                                     "UTF-8",
-                                                     convert_str,
-                                                     sizeof(convert_str) - 1,
-                                                     value,
-                                                     strlen(value));
-            if (convert_result > 0) {
-              value = static_cast<const char*>(convert_str);
-              result[i] = static_cast<std::string>(convert_str);
+            if (!pap_common_base::util::is_ascii(cell, length)) { //查表转换
+              save_length = pap_common_base::util::gbk_toutf8(
+                  save, length * 2 + 1, cell, length);
             }
 #endif
-            std::map<std::string, int32_t>::iterator it = 
-              map_string_buffer.find(result[i]);
-            if (it == map_string_buffer.end()) {
-              string_buffer.push_back(
-                  std::make_pair(result[i], string_buffer_size));
-              map_string_buffer.insert(
-                  std::make_pair(result[i], 
-                  static_cast<int32_t>(string_buffer.size()) - 1));
-              _field_data.int_value = string_buffer_size + 1;
-              string_buffer_size += 
-                static_cast<int32_t>(strlen(result[i].c_str())) + 1;
+            if (save_length < 0) {
+              memcpy(save, cell, length);
+              save_length = length;
+            }
+            save[save_length] = '\0';
+            //intern
+            uint32_t mask = static_cast<uint32_t>(string_slot.size()) - 1;
+            uint32_t slot = string_hash(save, save_length) & mask;
+            while (string_slot[slot] != -1) {
+              const char* exist = &(string_buffer[string_slot[slot]]);
+              if (0 == memcmp(exist, save, save_length + 1)) break;
+              slot = (slot + 1) & mask;
+            }
+            if (string_slot[slot] != -1) {
+              _field_data.int_value = string_slot[slot];
+              string_buffer.resize(offset);
+              break;
             }
-            else {
-              _field_data.int_value = string_buffer[it->second].second + 1;
+            string_slot[slot] = offset;
+            _field_data.int_value = offset;
+            string_buffer.resize(offset + save_length + 1);
+            ++string_count;
+            if (string_count * 2 > string_slot.size()) { //rehash
+              std::vector<int32_t> old_slot;
+              old_slot.swap(string_slot);
+              string_slot.resize(old_slot.size() * 2, -1);
+              mask = static_cast<uint32_t>(string_slot.size()) - 1;
+              uint32_t k;
+              for (k = 0; k < old_slot.size(); ++k) {
+                if (-1 == old_slot[k]) continue;
+                const char* exist = &(string_buffer[old_slot[k]]);
+                slot = string_hash(exist, 
+                                   static_cast<int32_t>(strlen(exist))) & mask;
+                while (string_slot[slot] != -1) slot = (slot + 1) & mask;
+                string_slot[slot] = old_slot[k];
+              }
             }
-            data_buffer_.push_back(_field_data);
             break;
           }
           default: {
             return false;
           }
         }
+        data_buffer_.push_back(_field_data);
+      }
+      //多出的列忽略
+      while (!line_end && _memory < end) {
+        _memory = find_separator(_memory, end);
+        if (_memory < end && '\t' == *_memory) {
+          ++_memory;
+        }
+        else {
+          line_end = true;
+        }
       }
       ++record_number;
-    } while (loop); 
+    }
     //database init
     record_number_ = record_number;
     field_number_ = field_number;
-    string_buffer_size_ = string_buffer_size + 1;
+    string_buffer_size_ = static_cast<int32_t>(string_buffer.size());
+    SAFE_DELETE_ARRAY(string_buffer_);
     string_buffer_ = new char[string_buffer_size_];
-    memset(string_buffer_, 0, string_buffer_size_);
+    memcpy(string_buffer_, &(string_buffer[0]), string_buffer_size_);
     type_ = _field_type;
-    unsigned char blank = '\0';
-    USE_PARAM(blank);
-    string_buffer_[0] = '\0';
-    
-    register char* temp = string_buffer_ + 1;
-    for (i = 0; i < static_cast<int32_t>(string_buffer.size()); ++i) {
-      memcpy(temp, 
-             string_buffer[i].first.c_str(), 
-             string_buffer[i].first.size());
-      temp += string_buffer[i].first.size();
-      *(temp++) = '\0';
-    }
 
     //relocate string block
-    register uint16_t m, n;
+    register int32_t m, n;
     for (m = 0; m < field_number; ++m) {
       if (type_[m] != kTypeString) continue;
       for (n = 0; n < record_number; ++n) {
         field_data &_field_data1 = data_buffer_[(n * field_number) + m];
         _field_data1.string_value = string_buffer_ + _field_data1.int_value;
-        printf("_field_data1.string_value: %s\n", _field_data1.string_value);
       }
     }
     create_index(0, filename);
@@ -405,80 +632,696 @@ bool Database::open_from_memory_text(const char* memory,
 }
 
 bool Database::open_from_memory_binary(const char* memory, 
-                             const char* end, 
-                             const char* filename) {
+                                       const char* end, 
+                                       const char* filename,
+                                       bool copy_string) {
   __ENTER_FUNCTION
-    register const char* _memory = memory;
-    file_head_t file_head;
-    memcpy(&file_head, _memory, sizeof(file_head_t));
-    if (file_head.identify != 0XDDBBCC00) return false;
+    uint64_t memory_size = static_cast<uint64_t>(end - memory);
+    binary_head_t binary_head;
+    if (memory_size < sizeof(binary_head)) return false;
+    memcpy(&binary_head, memory, sizeof(binary_head));
+    const file_head_t &file_head = binary_head.head;
+    if (file_head.identify != kDatabaseBinaryIdentify ||
+        binary_head.version != kDatabaseBinaryVersion ||
+        file_head.field_number <= 0 ||
+        file_head.record_number < 0 ||
+        file_head.string_block_size < 0 ||
+        binary_head.index_number < 0) {
+      return false;
+    }
     //check memory size
-    if (sizeof(file_head) +
-        sizeof(uint32_t) * file_head.field_number +
-        sizeof(field_data) * file_head.record_number * file_head.field_number +
-        + file_head.string_block_size > static_cast<uint64_t>(end - memory)) {
+    uint64_t cell_number = 
+      static_cast<uint64_t>(file_head.record_number) * file_head.field_number;
+    uint64_t total_size = sizeof(binary_head) +
+                          sizeof(uint32_t) * file_head.field_number +
+                          sizeof(uint32_t) * cell_number +
+                          file_head.string_block_size +
+                          sizeof(binary_index_t) * binary_head.index_number;
+    if (total_size > memory_size) return false;
+    if (binary_head.checksum != 
+        pap_common_base::util::crc32(
+          memory + sizeof(binary_head), 
+          static_cast<uint32_t>(total_size - sizeof(binary_head)))) {
       return false;
     }
-    _memory += sizeof(file_head);
-    
+    const char* _memory = memory + sizeof(binary_head);
+    const uint32_t* field_type = reinterpret_cast<const uint32_t*>(_memory);
+    _memory += sizeof(uint32_t) * file_head.field_number;
+    const uint32_t* cell = reinterpret_cast<const uint32_t*>(_memory);
+    _memory += sizeof(uint32_t) * cell_number;
+    const char* string_block = _memory;
+    _memory += file_head.string_block_size;
+    const binary_index_t* index = 
+      reinterpret_cast<const binary_index_t*>(_memory);
+
+    //check it
+    type_.resize(file_head.field_number);
+    int32_t i;
+    for (i = 0; i < file_head.field_number; ++i) {
+      if (field_type[i] != kTypeInt && 
+          field_type[i] != kTypeFloat && 
+          field_type[i] != kTypeString) {
+        return false;
+      }
+      type_[i] = static_cast<field_type_enum>(field_type[i]);
+    }
+
     //init 
     record_number_ = file_head.record_number;
     field_number_ = file_head.field_number;
     string_buffer_size_= file_head.string_block_size;
-    
-    //create string blok
-    string_buffer_ = new char[string_buffer_size_];
-    if (!string_buffer_) return false;
+    if (copy_string) { //内存由调用者释放时需要复制字符串区
+      SAFE_DELETE_ARRAY(string_buffer_);
+      string_buffer_ = new char[string_buffer_size_ + 1];
+      if (!string_buffer_) return false;
+      memcpy(string_buffer_, string_block, string_buffer_size_);
+      string_buffer_[string_buffer_size_] = '\0';
+      string_block = string_buffer_;
+    }
+
+    //runtime address, 没有解析过程只需要一次遍历
+    data_buffer_.resize(static_cast<size_t>(cell_number));
+    int32_t j;
+    for (i = 0; i < record_number_; ++i) {
+      for (j = 0; j < field_number_; ++j) {
+        uint32_t value = cell[i * field_number_ + j];
+        field_data &_field_data = data_buffer_[i * field_number_ + j];
+        if (kTypeString == type_[j]) {
+          if (value >= static_cast<uint32_t>(string_buffer_size_)) {
+            return false;
+          }
+          _field_data.string_value = string_block + value;
+        }
+        else { //整数和浮点数共用这4个字节
+          _field_data.int_value = static_cast<int32_t>(value);
+        }
+      }
+    }
+
+    //预先生成的索引已经检查过重复
+    if (binary_head.index_column >= 0 && 
+        binary_head.index_column < field_number_) {
+      hash_index_.clear();
+#if defined(__LINUX__)
+      hash_index_.resize(binary_head.index_number);
+#endif
+      for (i = 0; i < binary_head.index_number; ++i) {
+        if (index[i].line < 0 || index[i].line >= record_number_) continue;
+        hash_index_.insert(
+            std::make_pair(index[i].key, 
+                           &(data_buffer_[index[i].line * field_number_])));
+      }
+      index_column_ = binary_head.index_column;
+    }
+    else {
+      create_index(0, filename);
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Database::open_from_mapping(const char* filename) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    //只读共享映射，同一台机器上的进程共用这些页
+    int32_t handle = open(filename, O_RDONLY);
+    if (handle < 0) return false;
+    struct stat file_stat;
+    if (fstat(handle, &file_stat) != 0 || file_stat.st_size <= 0) {
+      close(handle);
+      return false;
+    }
+    void* memory = 
+      mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, handle, 0);
+    close(handle);
+    if (MAP_FAILED == memory) return false;
+    mapped_memory_ = static_cast<char*>(memory);
+    mapped_size_ = static_cast<uint32_t>(file_stat.st_size);
+    bool result = open_from_memory_binary(mapped_memory_, 
+                                          mapped_memory_ + mapped_size_, 
+                                          filename, 
+                                          false);
+    if (!result) {
+      munmap(mapped_memory_, mapped_size_);
+      mapped_memory_ = NULL;
+      mapped_size_ = 0;
+    }
+    return result;
+#else
+    FILE* fp = fopen(filename, "rb");
+    if (NULL == fp) return false;
+    fseek(fp, 0, SEEK_END);
+    int32_t filesize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* memory = new char[filesize];
+    fread(memory, 1, filesize, fp);
+    fclose(fp);
+    bool result = open_from_memory_binary(memory, memory + filesize, filename);
+    SAFE_DELETE_ARRAY(memory);
+    return result;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+struct BinaryIndexLess {
+  bool operator()(const Database::binary_index_t &index1, 
+                  const Database::binary_index_t &index2) const {
+    return index1.key < index2.key;
+  }
+};
+
+bool Database::save_to_binary(const char* filename) {
+  __ENTER_FUNCTION
+    Assert(filename);
+    if (field_number_ <= 0) return false;
+    //字符串按指针合并，文本载入时相同的字符串已经指向同一个位置
+    std::map<const char*, uint32_t> string_offset;
+    std::string string_block;
+    string_block.push_back('\0'); //偏移0为空字符串
+    std::vector<uint32_t> cell;
+    cell.resize(record_number_ * field_number_);
+    int32_t i, j;
+    for (i = 0; i < record_number_; ++i) {
+      for (j = 0; j < field_number_; ++j) {
+        const field_data &_field_data = data_buffer_[i * field_number_ + j];
+        uint32_t &value = cell[i * field_number_ + j];
+        if (kTypeString == type_[j]) {
+          const char* str = _field_data.string_value;
+          if (NULL == str || '\0' == str[0]) {
+            value = 0;
+            continue;
+          }
+          std::map<const char*, uint32_t>::iterator it = 
+            string_offset.find(str);
+          if (it != string_offset.end()) {
+            value = it->second;
+            continue;
+          }
+          value = static_cast<uint32_t>(string_block.size());
+          string_offset.insert(std::make_pair(str, value));
+          string_block.append(str);
+          string_block.push_back('\0');
+        }
+        else {
+          memcpy(&value, &_field_data, sizeof(value));
+        }
+      }
+    }
+    while (string_block.size() % 4 != 0) string_block.push_back('\0');
+    std::vector<binary_index_t> index;
+    if (0 == type_.size() || kTypeInt == type_[0]) {
+      field_hashmap::const_iterator it;
+      for (it = hash_index_.begin(); it != hash_index_.end(); ++it) {
+        binary_index_t item;
+        item.key = it->first;
+        item.line = 
+          static_cast<int32_t>(it->second - &(data_buffer_[0])) / field_number_;
+        index.push_back(item);
+      }
+      //哈希表的遍历顺序不固定，按key排序后写入
+      std::sort(index.begin(), index.end(), BinaryIndexLess());
+    }
     std::vector<uint32_t> field_type;
-    field_type.resize(field_number_);
-    memcpy(&(field_type[0]), _memory, sizeof(uint32_t) * field_number_);
+    for (j = 0; j < field_number_; ++j) field_type.push_back(type_[j]);
+    std::string body;
+    body.append(reinterpret_cast<const char*>(&(field_type[0])), 
+                sizeof(uint32_t) * field_type.size());
+    if (!cell.empty()) {
+      body.append(reinterpret_cast<const char*>(&(cell[0])), 
+                  sizeof(uint32_t) * cell.size());
+    }
+    body.append(string_block);
+    if (!index.empty()) {
+      body.append(reinterpret_cast<const char*>(&(index[0])), 
+                  sizeof(binary_index_t) * index.size());
+    }
+    binary_head_t binary_head;
+    binary_head.head.identify = kDatabaseBinaryIdentify;
+    binary_head.head.field_number = field_number_;
+    binary_head.head.record_number = record_number_;
+    binary_head.head.string_block_size = 
+      static_cast<int32_t>(string_block.size());
+    binary_head.version = kDatabaseBinaryVersion;
+    binary_head.checksum = pap_common_base::util::crc32(
+        body.data(), 
+        static_cast<uint32_t>(body.size()));
+    binary_head.index_column = index.empty() ? -1 : 0;
+    binary_head.index_number = static_cast<int32_t>(index.size());
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) return false;
+    bool result = 1 == fwrite(&binary_head, sizeof(binary_head), 1, fp) &&
+                  1 == fwrite(body.data(), body.size(), 1, fp);
+    fclose(fp);
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
 
-    //check it
-    type_.resize(field_number_);
+//-- index
+struct IndexLess {
+  const Database* database;
+  const Database::index_t* index;
+  bool operator()(int32_t line1, int32_t line2) const { //for sort
+    Database::field_data key[kDatabaseIndexColumnMax];
     int32_t i;
-    for (i = 0; i < field_number_; ++i) {
-      switch(field_type[i]) {
-        case kTypeInt: {
-          //do nothing
+    for (i = 0; i < index->column_number; ++i) {
+      key[i] = database->data_buffer_[
+        line2 * database->field_number_ + index->column[i]];
+    }
+    return database->index_compare(*index, line1, key) < 0;
+  }
+  bool operator()(int32_t line, const Database::field_data* key) const {
+    return database->index_compare(*index, line, key) < 0;
+  }
+  bool operator()(const Database::field_data* key, int32_t line) const {
+    return database->index_compare(*index, line, key) > 0;
+  }
+};
+
+int32_t Database::declare_index(index_type_enum type, int32_t column) {
+  __ENTER_FUNCTION
+    return get_index(type, &column, 1);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+int32_t Database::declare_index(index_type_enum type, 
+                                int32_t column1, 
+                                int32_t column2) {
+  __ENTER_FUNCTION
+    int32_t column[2] = {column1, column2};
+    return get_index(type, column, 2);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+int32_t Database::declare_index(index_type_enum type, 
+                                const int32_t* column, 
+                                int32_t column_number) {
+  __ENTER_FUNCTION
+    return get_index(type, column, column_number);
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+void Database::build_index() {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < static_cast<int32_t>(index_.size()); ++i) {
+      if (!index_[i].built) build_index(i);
+    }
+  __LEAVE_FUNCTION
+}
+
+const Database::field_data* Database::search_index(
+    int32_t index, 
+    const field_data* key) const {
+  __ENTER_FUNCTION
+    if (index < 0 || index >= static_cast<int32_t>(index_.size()) || !key) {
+      return NULL;
+    }
+    const index_t &_index = index_[index];
+    if (!_index.built) {
+      int32_t line;
+      for (line = 0; line < record_number_; ++line) {
+        if (0 == index_compare(_index, line, key)) {
+          return &(data_buffer_[line * field_number_]);
         }
-        case kTypeFloat: {
-          //do nothing
+      }
+      return NULL;
+    }
+    if (_index.line.empty()) return NULL;
+    if (kIndexHash == _index.type) {
+      uint32_t mask = static_cast<uint32_t>(_index.line.size()) - 1;
+      uint32_t slot = index_hash(_index, key) & mask;
+      while (_index.line[slot] != 0) {
+        int32_t line = _index.line[slot] - 1;
+        if (0 == index_compare(_index, line, key)) {
+          return &(data_buffer_[line * field_number_]);
         }
-        case kTypeString: {
-          type_[i] = static_cast<field_type_enum>(field_type[i]);
-          break;
+        slot = (slot + 1) & mask;
+      }
+      return NULL;
+    }
+    IndexLess less;
+    less.database = this;
+    less.index = &_index;
+    std::vector<int32_t>::const_iterator it = 
+      std::lower_bound(_index.line.begin(), _index.line.end(), key, less);
+    if (it == _index.line.end() || index_compare(_index, *it, key) != 0) {
+      return NULL;
+    }
+    return &(data_buffer_[(*it) * field_number_]);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+int32_t Database::search_index_all(
+    int32_t index, 
+    const field_data* key, 
+    std::vector<const field_data*> &result) const {
+  __ENTER_FUNCTION
+    result.clear();
+    if (index < 0 || index >= static_cast<int32_t>(index_.size()) || !key) {
+      return 0;
+    }
+    const index_t &_index = index_[index];
+    if (!_index.built) {
+      std::vector<int32_t> line;
+      scan_index(_index, key, key, line);
+      uint32_t i;
+      for (i = 0; i < line.size(); ++i) {
+        result.push_back(&(data_buffer_[line[i] * field_number_]));
+      }
+      return static_cast<int32_t>(result.size());
+    }
+    if (_index.line.empty()) return 0;
+    if (kIndexHash == _index.type) {
+      uint32_t mask = static_cast<uint32_t>(_index.line.size()) - 1;
+      uint32_t slot = index_hash(_index, key) & mask;
+      while (_index.line[slot] != 0) { //按行号顺序插入，结果也是行号顺序
+        int32_t line = _index.line[slot] - 1;
+        if (0 == index_compare(_index, line, key)) {
+          result.push_back(&(data_buffer_[line * field_number_]));
         }
-        default: {
-          SAFE_DELETE_ARRAY(string_buffer_);
-          return false;
+        slot = (slot + 1) & mask;
+      }
+    }
+    else {
+      search_index_range(index, key, key, result);
+    }
+    return static_cast<int32_t>(result.size());
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+int32_t Database::search_index_range(
+    int32_t index, 
+    const field_data* low, 
+    const field_data* high,
+    std::vector<const field_data*> &result) const {
+  __ENTER_FUNCTION
+    result.clear();
+    if (index < 0 || index >= static_cast<int32_t>(index_.size()) || 
+        !low || !high) {
+      return 0;
+    }
+    if (index_[index].type != kIndexSorted) return 0;
+    const index_t &_index = index_[index];
+    IndexLess less;
+    less.database = this;
+    less.index = &_index;
+    if (!_index.built) { //逐行查找后按索引顺序排列
+      std::vector<int32_t> line;
+      scan_index(_index, low, high, line);
+      std::stable_sort(line.begin(), line.end(), less);
+      uint32_t i;
+      for (i = 0; i < line.size(); ++i) {
+        result.push_back(&(data_buffer_[line[i] * field_number_]));
+      }
+      return static_cast<int32_t>(result.size());
+    }
+    std::vector<int32_t>::const_iterator first = 
+      std::lower_bound(_index.line.begin(), _index.line.end(), low, less);
+    std::vector<int32_t>::const_iterator last = 
+      std::upper_bound(first, _index.line.end(), high, less);
+    for (; first < last; ++first) {
+      result.push_back(&(data_buffer_[(*first) * field_number_]));
+    }
+    return static_cast<int32_t>(result.size());
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+int32_t Database::find_index(index_type_enum type, 
+                             const int32_t* column, 
+                             int32_t column_number) const {
+  __ENTER_FUNCTION
+    if (!column || column_number <= 0) return -1;
+    int32_t i, j;
+    for (i = 0; i < static_cast<int32_t>(index_.size()); ++i) {
+      const index_t &_index = index_[i];
+      if (_index.type != type || _index.column_number != column_number) {
+        continue;
+      }
+      for (j = 0; j < column_number; ++j) {
+        if (_index.column[j] != column[j]) break;
+      }
+      if (j == column_number) return i;
+    }
+    return -1;
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+int32_t Database::get_index(index_type_enum type, 
+                            const int32_t* column, 
+                            int32_t column_number) {
+  __ENTER_FUNCTION
+    if (!column || column_number <= 0 || 
+        column_number > kDatabaseIndexColumnMax) {
+      return -1;
+    }
+    int32_t i;
+    for (i = 0; i < column_number; ++i) {
+      if (column[i] < 0 || column[i] >= field_number_) return -1;
+      if (kIndexHash == type && kTypeFloat == type_[column[i]]) return -1;
+    }
+    int32_t result = find_index(type, column, column_number);
+    if (result >= 0) return result;
+    index_t _index;
+    _index.type = type;
+    _index.column_number = column_number;
+    memset(_index.column, 0, sizeof(_index.column));
+    for (i = 0; i < column_number; ++i) _index.column[i] = column[i];
+    _index.built = false;
+    index_.push_back(_index);
+    return static_cast<int32_t>(index_.size()) - 1;
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+void Database::build_index(int32_t index) {
+  __ENTER_FUNCTION
+    index_t &_index = index_[index];
+    _index.line.clear();
+    if (kIndexHash == _index.type) {
+      uint32_t size = 16; //装载率不超过一半
+      while (size < static_cast<uint32_t>(record_number_) * 2) size <<= 1;
+      _index.line.resize(size, 0);
+      uint32_t mask = size - 1;
+      field_data key[kDatabaseIndexColumnMax];
+      int32_t i, j;
+      for (i = 0; i < record_number_; ++i) {
+        for (j = 0; j < _index.column_number; ++j) {
+          key[j] = data_buffer_[i * field_number_ + _index.column[j]];
         }
+        uint32_t slot = index_hash(_index, key) & mask;
+        while (_index.line[slot] != 0) slot = (slot + 1) & mask;
+        _index.line[slot] = i + 1;
+      }
+    }
+    else {
+      _index.line.resize(record_number_);
+      int32_t i;
+      for (i = 0; i < record_number_; ++i) _index.line[i] = i;
+      IndexLess less;
+      less.database = this;
+      less.index = &_index;
+      std::stable_sort(_index.line.begin(), _index.line.end(), less);
+    }
+    _index.built = true;
+  __LEAVE_FUNCTION
+}
+
+void Database::scan_index(const index_t &index, 
+                          const field_data* low, 
+                          const field_data* high, 
+                          std::vector<int32_t> &line) const {
+  __ENTER_FUNCTION
+    line.clear();
+    int32_t i;
+    for (i = 0; i < record_number_; ++i) {
+      if (index_compare(index, i, low) >= 0 && 
+          index_compare(index, i, high) <= 0) {
+        line.push_back(i);
       }
     }
+  __LEAVE_FUNCTION
+}
 
-    //read all field
-    data_buffer_.resize(field_number_ * record_number_);
-    memcpy(&(data_buffer_[0]), 
-           _memory, 
-           sizeof(field_data) * field_number_ * record_number_);
-    _memory += sizeof(field_data) * field_number_ * record_number_;
-    memcpy(string_buffer_, _memory, string_buffer_size_);
-    string_buffer_[string_buffer_size_ - 1] = '\0';
+void Database::reset_index() {
+  __ENTER_FUNCTION
+    uint32_t i;
+    for (i = 0; i < index_.size(); ++i) {
+      index_[i].built = false;
+      index_[i].line.clear();
+    }
+    column_built_ = false;
+    column_offset_.clear();
+    column_value_.clear();
+    column_string_.clear();
+  __LEAVE_FUNCTION
+}
 
-    //runtime address
-    for (i = 0; i < field_number_; ++i) {
-      if (field_type[i] != kTypeString) continue;
-      std::string str;
-      int32_t _field_number;
-      int32_t j;
-      for (j = 0; j < record_number_; ++j) {
-        _field_number = get_field_number();
-        data_buffer_[i + field_number_ + j].string_value += 
-          reinterpret_cast<uint64_t>(string_buffer_); 
+uint32_t Database::index_hash(const index_t &index, 
+                              const field_data* key) const {
+  __ENTER_FUNCTION
+    uint32_t result = 0;
+    int32_t i;
+    for (i = 0; i < index.column_number; ++i) {
+      uint32_t hash;
+      if (kTypeString == type_[index.column[i]]) {
+        const char* str = key[i].string_value ? key[i].string_value : "";
+        hash = string_hash(str, static_cast<int32_t>(strlen(str)));
       }
+      else {
+        hash = static_cast<uint32_t>(key[i].int_value) * 2654435761u;
+      }
+      result ^= hash + 0x9e3779b9 + (result << 6) + (result >> 2);
     }
-    create_index(0, filename);
+    return result;
   __LEAVE_FUNCTION
-    return false;
+    return 0;
+}
+
+int32_t Database::index_compare(const index_t &index, 
+                                int32_t line, 
+                                const field_data* key) const {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < index.column_number; ++i) {
+      int32_t column = index.column[i];
+      int32_t result = field_compare(type_[column], 
+                                     data_buffer_[line * field_number_ + column],
+                                     key[i]);
+      if (result != 0) return result;
+    }
+    return 0;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+//index --
+
+//-- column
+template <> 
+const int32_t* Database::column<int32_t>(int32_t index) const {
+  __ENTER_FUNCTION
+    if (index < 0 || index >= field_number_ || kTypeInt != type_[index]) {
+      return NULL;
+    }
+    if (!column_built_ || 0 == record_number_) return NULL;
+    return &(column_value_[column_offset_[index]]);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+template <> 
+const float* Database::column<float>(int32_t index) const {
+  __ENTER_FUNCTION
+    if (index < 0 || index >= field_number_ || kTypeFloat != type_[index]) {
+      return NULL;
+    }
+    if (!column_built_ || 0 == record_number_) return NULL;
+    return reinterpret_cast<const float*>(
+        &(column_value_[column_offset_[index]]));
+  __LEAVE_FUNCTION
+    return NULL;
 }
 
+template <> 
+const char* const* Database::column<const char*>(int32_t index) const {
+  __ENTER_FUNCTION
+    if (index < 0 || index >= field_number_ || kTypeString != type_[index]) {
+      return NULL;
+    }
+    if (!column_built_ || 0 == record_number_) return NULL;
+    return &(column_string_[column_offset_[index]]);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void Database::build_column() {
+  __ENTER_FUNCTION
+    if (!column_built_) create_column();
+  __LEAVE_FUNCTION
+}
+
+int32_t Database::search_column_range(int32_t index, 
+                                      int32_t low, 
+                                      int32_t high, 
+                                      std::vector<int32_t> &line) const {
+  __ENTER_FUNCTION
+    line.clear();
+    if (index < 0 || index >= field_number_ || kTypeInt != type_[index]) {
+      return 0;
+    }
+    //先按最多的结果分配，循环中无分支写入，最后截断
+    line.resize(record_number_);
+    int32_t count = 0;
+    register int32_t i;
+    const int32_t* value = column<int32_t>(index);
+    if (value) { //列存储是连续数组
+      for (i = 0; i < record_number_; ++i) {
+        line[count] = i;
+        count += value[i] >= low && value[i] <= high;
+      }
+    }
+    else { //没有生成列存储时按行跨步读取
+      for (i = 0; i < record_number_; ++i) {
+        int32_t _value = data_buffer_[i * field_number_ + index].int_value;
+        line[count] = i;
+        count += _value >= low && _value <= high;
+      }
+    }
+    line.resize(count);
+    return count;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+void Database::create_column() {
+  __ENTER_FUNCTION
+    column_offset_.resize(field_number_);
+    column_value_.clear();
+    column_string_.clear();
+    int32_t value_number = 0;
+    int32_t string_number = 0;
+    int32_t i, j;
+    for (j = 0; j < field_number_; ++j) {
+      if (kTypeString == type_[j]) {
+        column_offset_[j] = string_number;
+        string_number += record_number_;
+      }
+      else {
+        column_offset_[j] = value_number;
+        value_number += record_number_;
+      }
+    }
+    column_value_.resize(value_number);
+    column_string_.resize(string_number);
+    for (j = 0; j < field_number_; ++j) {
+      int32_t offset = column_offset_[j];
+      if (kTypeString == type_[j]) {
+        for (i = 0; i < record_number_; ++i) {
+          column_string_[offset + i] = 
+            data_buffer_[i * field_number_ + j].string_value;
+        }
+      }
+      else {
+        for (i = 0; i < record_number_; ++i) {
+          column_value_[offset + i] = 
+            data_buffer_[i * field_number_ + j].int_value;
+        }
+      }
+    }
+    column_built_ = true;
+  __LEAVE_FUNCTION
+}
+
+//column --
+
 } //namespace pap_common_file
@@ -8,6 +8,8 @@ Ini::Ini() {
     data_info_ = NULL;
     section_number_ = 0;
     section_indexlist_ = NULL;
+    memset(file_name_, '\0', sizeof(file_name_));
+    memset(key_, '\0', sizeof(key_));
   __LEAVE_FUNCTION
 }
 
@@ -20,6 +22,7 @@ Ini::Ini(const char* file_name) {
     memset(file_name_, '\0', sizeof(file_name_));
     memset(value_, '\0', sizeof(value_));
     memset(ret_, '\0', sizeof(ret_));
+    memset(key_, '\0', sizeof(key_));
     open(file_name);
   __LEAVE_FUNCTION
 }
@@ -70,6 +73,7 @@ bool Ini::open(const char* file_name) {
       memset(data_info_, '\0', sizeof(data_info_));
       init_section();
     }
+    build_index();
     return result;
   __LEAVE_FUNCTION
     return false;
@@ -85,6 +89,9 @@ void Ini::close() {
       SAFE_DELETE(section_indexlist_);
       section_number_ = 0;
     }
+    text_.clear();
+    entry_.clear();
+    entry_slot_.clear();
   __LEAVE_FUNCTION
 }
 
@@ -202,17 +209,16 @@ char* Ini::find_key(int32_t &position) {
     char _char;
     char* ret;
     int32_t m, i;
-    uint16_t kKeyLength = 64;
     m = 0;
-    ret = new char[kKeyLength];
-    memset(ret, '\0', kKeyLength);
+    ret = key_; //以前每次new且没有释放
+    memset(ret, '\0', sizeof(key_));
     for (i = position; i < data_length_; ++i) {
       _char = data_info_[i];
       if ('\r' == _char || '\n' == _char || '=' == _char || ';' == _char) {
         position = i + 1;
         break;
       }
-      ret[m] = _char;
+      if (m < static_cast<int32_t>(sizeof(key_)) - 1) ret[m] = _char;
       ++m;
     }
     return ret;
@@ -264,6 +270,7 @@ bool Ini::add_section(const char* section) {
                str);
       data_length_ += static_cast<int64_t>(strlen(str));
       init_section();
+      build_index();
       result = true;
     }
     return result;
@@ -350,24 +357,20 @@ void Ini::readstring(const char* section,
              file_name_, 
              section, 
              key);
-    int32_t section_index = find_section_index(section);
-    AssertEx(section_index != -1, temp);
-    if (-1 == section_index) return;
-    int32_t data_index = find_key_index(section_index, key);
-    if (-1 == data_index) return;
-    char* ret = readstring(data_index);
-    strncpy(str, ret, length);
+    entry_t* section_entry = find_entry(section);
+    AssertEx(section_entry != NULL, temp);
+    if (NULL == section_entry) return;
+    entry_t* entry = find_entry(section, key);
+    if (NULL == entry) return;
+    strncpy(str, &text_[entry->value], length);
   __LEAVE_FUNCTION
 }
 
 bool Ini::read_existstring(const char* section, const char* key, char* str, int32_t length) {
   __ENTER_FUNCTION
-    int32_t section_index = find_section_index(section);
-    if (-1 == section_index) return false;
-    int32_t data_index = find_key_index(section_index, key);
-    if (-1 == data_index) return false;
-    char* ret = readstring(data_index);
-    strncpy(str, ret, length);
+    entry_t* entry = find_entry(section, key);
+    if (NULL == entry) return false;
+    strncpy(str, &text_[entry->value], length);
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -429,17 +432,12 @@ int64_t Ini::read_int64(const char* section, const char* key) {
     char temp[512];
     memset(temp, '\0', sizeof(temp));
     snprintf(temp, sizeof(temp), "[file:%s][section:%s][key:%s]", file_name_, section, key);
-    int32_t section_index = find_section_index(section);
-    AssertEx(section_index != -1, temp);
-    int32_t data_index = find_key_index(section_index, key);
-    AssertEx(data_index, temp);
-    char* str = readstring(data_index);
-    int64_t result = ERROR_DATA;
-#if defined(__LINUX__)
-    result = static_cast<int64_t>(atoll(str));
-#elif defined(__WINDOWS__)
-    result = static_cast<int64_t>(atol(str));
-#endif 
+    entry_t* section_entry = find_entry(section);
+    AssertEx(section_entry != NULL, temp);
+    if (NULL == section_entry) return ERROR_DATA;
+    entry_t* entry = find_entry(section, key);
+    if (NULL == entry) return 0;
+    int64_t result = get_int64(entry);
     return result;
   __LEAVE_FUNCTION
     return ERROR_DATA;
@@ -447,14 +445,9 @@ int64_t Ini::read_int64(const char* section, const char* key) {
 
 bool Ini::read_exist_int64(const char* section, const char* key, int64_t &result) {
   __ENTER_FUNCTION
-    int32_t section_index = find_section_index(section);
-    int32_t data_index = find_key_index(section_index, key);
-    char* str = readstring(data_index);
-#if defined(__LINUX__)
-    result = static_cast<int64_t>(atoll(str));
-#elif defined(__WINDOWS__)
-    result = static_cast<int64_t>(atol(str));
-#endif
+    entry_t* entry = find_entry(section, key);
+    if (NULL == entry) return false; //以前不存在时也返回true
+    result = get_int64(entry);
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -503,13 +496,16 @@ float Ini::read_float(const char* section, const char* key) {
     char temp[512];
     memset(temp, '\0', sizeof(temp));
     snprintf(temp, sizeof(temp), "[file:%s][section:%s][key:%s]", file_name_, section, key);
-    int32_t section_index = find_section_index(section);
-    AssertEx(section_index != -1, temp);
-    int32_t data_index = find_key_index(section_index, key);
-    AssertEx(data_index, temp);
-    char* str = readstring(data_index);
-    float result = static_cast<float>(atof(str));
-    return result;
+    entry_t* section_entry = find_entry(section);
+    AssertEx(section_entry != NULL, temp);
+    if (NULL == section_entry) return static_cast<float>(ERROR_DATA);
+    entry_t* entry = find_entry(section, key);
+    if (NULL == entry) return 0.0f;
+    if (!entry->float_cached) {
+      entry->float_value = static_cast<float>(atof(&text_[entry->value]));
+      entry->float_cached = true;
+    }
+    return entry->float_value;
   __LEAVE_FUNCTION
     return static_cast<float>(ERROR_DATA);
 }
@@ -571,7 +567,7 @@ bool Ini::read_exist_int32(const char* section, const char* key, int32_t &result
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<int32_t>(temp);
+    if (_result) result = static_cast<int32_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -582,7 +578,7 @@ bool Ini::read_exist_uint32(const char* section, const char* key, uint32_t &resu
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<uint32_t>(temp);
+    if (_result) result = static_cast<uint32_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -593,7 +589,7 @@ bool Ini::read_exist_int16(const char* section, const char* key, int16_t &result
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<int16_t>(temp);
+    if (_result) result = static_cast<int16_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -604,7 +600,7 @@ bool Ini::read_exist_uint16(const char* section, const char* key, uint16_t &resu
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<uint16_t>(temp);
+    if (_result) result = static_cast<uint16_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -615,7 +611,7 @@ bool Ini::read_exist_int8(const char* section, const char* key, int8_t &result)
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<int8_t>(temp);
+    if (_result) result = static_cast<int8_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -626,7 +622,7 @@ bool Ini::read_exist_uint8(const char* section, const char* key, uint8_t &result
     bool _result = false;
     int64_t temp;
     _result = read_exist_int64(section, key, temp);
-    result = static_cast<uint8_t>(temp);
+    if (_result) result = static_cast<uint8_t>(temp); //不存在时保持原值
     return _result;
   __LEAVE_FUNCTION
     return false;
@@ -700,6 +696,7 @@ bool Ini::write(const char* section, const char* key, int32_t value) {
       }
       result = true;
     }
+    build_index();
     return result;
   __LEAVE_FUNCTION
     return false;
@@ -731,6 +728,7 @@ bool Ini::write(const char* section, const char* key, const char* value) {
       }
       result = true;
     }
+    build_index();
     return result;
   __LEAVE_FUNCTION
     return false;
@@ -810,4 +808,144 @@ int32_t Ini::get_line_number(const char* str) {
     return -1;
 }
 
+//-- index
+static uint32_t ini_hash(const char* section, const char* key) {
+  uint32_t hash = 2166136261u; //FNV-1a
+  const unsigned char* str = reinterpret_cast<const unsigned char*>(section);
+  for (; *str; ++str) hash = (hash ^ *str) * 16777619u;
+  hash = (hash ^ (key ? 0 : 1)) * 16777619u; //区分节和键
+  if (key) {
+    str = reinterpret_cast<const unsigned char*>(key);
+    for (; *str; ++str) hash = (hash ^ *str) * 16777619u;
+  }
+  return hash;
+}
+
+void Ini::build_index() {
+  __ENTER_FUNCTION
+    //与原来的读取规则相同：节名到 \r \n \t ; ] 为止，
+    //键名到 = 为止，值到 \r \n \t ; ] 为止
+    text_.clear();
+    entry_.clear();
+    entry_slot_.clear();
+    text_.reserve(static_cast<size_t>(data_length_) + 16);
+    int32_t section = -1;
+    int32_t position = 0;
+    int32_t length = static_cast<int32_t>(data_length_);
+    while (position < length) {
+      int32_t line_end = position;
+      while (line_end < length && data_info_[line_end] != '\n') ++line_end;
+      entry_t entry;
+      memset(&entry, 0, sizeof(entry));
+      entry.key = -1;
+      entry.value = -1;
+      if ('[' == data_info_[position]) {
+        int32_t i = position + 1;
+        section = static_cast<int32_t>(text_.size());
+        while (i < line_end && 
+               data_info_[i] != '\r' && 
+               data_info_[i] != '\t' && 
+               data_info_[i] != ';' && 
+               data_info_[i] != ']') {
+          text_.push_back(data_info_[i++]);
+        }
+        text_.push_back('\0');
+        entry.section = section;
+        entry_.push_back(entry);
+      }
+      else if (section >= 0) {
+        int32_t i = position;
+        while (i < line_end && 
+               data_info_[i] != '\r' && 
+               data_info_[i] != '=' && 
+               data_info_[i] != ';') {
+          ++i;
+        }
+        if (i > position && i < line_end && '=' == data_info_[i]) {
+          entry.section = section;
+          entry.key = static_cast<int32_t>(text_.size());
+          text_.insert(text_.end(), data_info_ + position, data_info_ + i);
+          text_.push_back('\0');
+          entry.value = static_cast<int32_t>(text_.size());
+          ++i;
+          while (i < line_end && 
+                 data_info_[i] != '\r' && 
+                 data_info_[i] != '\t' && 
+                 data_info_[i] != ';' && 
+                 data_info_[i] != ']' &&
+                 data_info_[i] != '\0') {
+            text_.push_back(data_info_[i++]);
+          }
+          text_.push_back('\0');
+          entry_.push_back(entry);
+        }
+      }
+      position = line_end + 1;
+    }
+    uint32_t size = 16;
+    while (size < entry_.size() * 2) size <<= 1;
+    entry_slot_.resize(size, -1);
+    uint32_t mask = size - 1;
+    uint32_t i;
+    for (i = 0; i < entry_.size(); ++i) {
+      entry_t &entry = entry_[i];
+      const char* section_name = &text_[entry.section];
+      const char* key_name = entry.key >= 0 ? &text_[entry.key] : NULL;
+      entry.hash = ini_hash(section_name, key_name);
+      uint32_t slot = entry.hash & mask;
+      bool exist = false;
+      while (entry_slot_[slot] != -1) {
+        const entry_t &other = entry_[entry_slot_[slot]];
+        if (other.hash == entry.hash &&
+            0 == strcmp(&text_[other.section], section_name) &&
+            (other.key >= 0) == (key_name != NULL) &&
+            (NULL == key_name || 0 == strcmp(&text_[other.key], key_name))) {
+          exist = true; //重复的节或键，与以前一样使用第一个
+          break;
+        }
+        slot = (slot + 1) & mask;
+      }
+      if (!exist) entry_slot_[slot] = static_cast<int32_t>(i);
+    }
+  __LEAVE_FUNCTION
+}
+
+Ini::entry_t* Ini::find_entry(const char* section, const char* key) {
+  __ENTER_FUNCTION
+    if (NULL == section || entry_slot_.empty()) return NULL;
+    uint32_t hash = ini_hash(section, key);
+    uint32_t mask = static_cast<uint32_t>(entry_slot_.size()) - 1;
+    uint32_t slot = hash & mask;
+    while (entry_slot_[slot] != -1) {
+      entry_t &entry = entry_[entry_slot_[slot]];
+      if (entry.hash == hash &&
+          0 == strcmp(&text_[entry.section], section) &&
+          (entry.key >= 0) == (key != NULL) &&
+          (NULL == key || 0 == strcmp(&text_[entry.key], key))) {
+        return &entry;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return NULL;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+int64_t Ini::get_int64(entry_t* entry) {
+  __ENTER_FUNCTION
+    if (!entry->int_cached) {
+#if defined(__LINUX__)
+      entry->int_value = static_cast<int64_t>(atoll(&text_[entry->value]));
+#elif defined(__WINDOWS__)
+      entry->int_value = static_cast<int64_t>(atol(&text_[entry->value]));
+#endif
+      entry->int_cached = true;
+    }
+    return entry->int_value;
+  __LEAVE_FUNCTION
+    return ERROR_DATA;
+}
+
+//index --
+
 } //namespace pap_common_file
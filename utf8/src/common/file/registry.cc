@@ -0,0 +1,309 @@
+#include "common/file/registry.h"
+#include "common/base/util.h"
+#include <sys/stat.h>
+#if defined(__LINUX__)
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+pap_common_file::Registry g_table_registry;
+
+namespace pap_common_file {
+
+//-- atomic helpers
+static void atomic_increment(volatile int32_t* value) {
+#if defined(__LINUX__)
+  __sync_fetch_and_add(value, 1);
+#elif defined(__WINDOWS__)
+  InterlockedIncrement(reinterpret_cast<volatile LONG*>(value));
+#endif
+}
+
+static void atomic_decrement(volatile int32_t* value) {
+#if defined(__LINUX__)
+  __sync_fetch_and_sub(value, 1);
+#elif defined(__WINDOWS__)
+  InterlockedDecrement(reinterpret_cast<volatile LONG*>(value));
+#endif
+}
+
+static int64_t get_modify_time(const char* filename) {
+  struct stat file_stat;
+  if (stat(filename, &file_stat) != 0) return 0;
+  return static_cast<int64_t>(file_stat.st_mtime);
+}
+//atomic helpers --
+
+Registry::Registry() {
+  __ENTER_FUNCTION
+    active_ = true;
+    table_count_ = 0;
+    epoch_ = 0;
+    watch_handle_ = -1;
+    memset(table_, 0, sizeof(table_));
+    memset(reader_, 0, sizeof(reader_));
+  __LEAVE_FUNCTION
+}
+
+Registry::~Registry() {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < table_count_; ++i) {
+      Database* database = table_[i].database;
+      SAFE_DELETE(database);
+      table_[i].database = NULL;
+    }
+#if defined(__LINUX__)
+    if (watch_handle_ >= 0) close(watch_handle_);
+#endif
+    watch_handle_ = -1;
+  __LEAVE_FUNCTION
+}
+
+bool Registry::add(uint32_t id,
+                   const char* filename,
+                   table_prepare_function prepare) {
+  __ENTER_FUNCTION
+    Assert(filename);
+    if (find(id) || table_count_ >= kRegistryTableMax) return false;
+    table_t* table = &table_[table_count_];
+    memset(table, 0, sizeof(table_t));
+    table->id = id;
+    strncpy(table->filename, filename, sizeof(table->filename) - 1);
+    table->prepare = prepare;
+    table->watch = -1;
+    if (!load(table)) return false;
+    ++table_count_;
+#if defined(__LINUX__)
+    //监视所在目录，编辑器通常是写新文件再改名
+    if (watch_handle_ < 0) watch_handle_ = inotify_init();
+    if (watch_handle_ >= 0) {
+      char directory[FILENAME_MAX];
+      strncpy(directory, filename, sizeof(directory) - 1);
+      directory[sizeof(directory) - 1] = '\0';
+      char* separator = strrchr(directory, '/');
+      if (separator) {
+        *separator = '\0';
+      }
+      else {
+        strncpy(directory, ".", sizeof(directory) - 1);
+      }
+      table->watch = inotify_add_watch(watch_handle_,
+                                       directory,
+                                       IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+#endif
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Registry::reload(uint32_t id) {
+  __ENTER_FUNCTION
+    table_t* table = find(id);
+    if (!table) return false;
+    table->reload = true;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+uint32_t Registry::get_version(uint32_t id) {
+  __ENTER_FUNCTION
+    table_t* table = find(id);
+    if (!table) return 0;
+    return table->version;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+int32_t Registry::read_begin(uint32_t &parity) {
+  __ENTER_FUNCTION
+    uint64_t thread_id = pap_common_sys::get_current_thread_id();
+    int32_t slot = static_cast<int32_t>(
+        ((thread_id >> 12) ^ thread_id) % kRegistryReaderSlotMax);
+    for (;;) {
+      uint32_t epoch = epoch_;
+      parity = epoch & 1;
+      atomic_increment(&reader_[slot].count[parity]);
+      //计数之后纪元没有变化，写者一定能看到这个读者
+      if (epoch == epoch_) break;
+      atomic_decrement(&reader_[slot].count[parity]);
+    }
+    return slot;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+void Registry::read_end(int32_t slot, uint32_t parity) {
+  __ENTER_FUNCTION
+    atomic_decrement(&reader_[slot].count[parity]);
+  __LEAVE_FUNCTION
+}
+
+const Database* Registry::get(uint32_t id) {
+  __ENTER_FUNCTION
+    table_t* table = find(id);
+    if (!table) return NULL;
+    pap_common_base::util::memory_barrier();
+    return table->database;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void Registry::run() {
+  __ENTER_FUNCTION
+    while (is_active()) {
+#if defined(__LINUX__)
+      if (watch_handle_ >= 0) {
+        struct pollfd watch_poll;
+        watch_poll.fd = watch_handle_;
+        watch_poll.events = POLLIN;
+        watch_poll.revents = 0;
+        if (poll(&watch_poll, 1, kRegistryCheckTime) > 0 &&
+            (watch_poll.revents & POLLIN)) {
+          char buffer[4096] __attribute__((aligned(8)));
+          ssize_t length = read(watch_handle_, buffer, sizeof(buffer));
+          ssize_t position = 0;
+          while (length > 0 && position < length) {
+            const struct inotify_event* event =
+              reinterpret_cast<const struct inotify_event*>(
+                  buffer + position);
+            position += sizeof(struct inotify_event) + event->len;
+            if (0 == event->len) continue;
+            int32_t i;
+            for (i = 0; i < table_count_; ++i) {
+              const char* name = strrchr(table_[i].filename, '/');
+              name = name ? name + 1 : table_[i].filename;
+              if (table_[i].watch == event->wd &&
+                  0 == strcmp(name, event->name)) {
+                table_[i].reload = true;
+              }
+            }
+          }
+        }
+      }
+      else {
+        pap_common_base::util::sleep(kRegistryCheckTime);
+        check_modify();
+      }
+#else
+      pap_common_base::util::sleep(kRegistryCheckTime);
+      check_modify();
+#endif
+      int32_t i;
+      for (i = 0; i < table_count_ && is_active(); ++i) {
+        if (!table_[i].reload) continue;
+        table_[i].reload = false;
+        load(&table_[i]);
+      }
+    }
+  __LEAVE_FUNCTION
+}
+
+void Registry::stop() {
+  __ENTER_FUNCTION
+    active_ = false;
+  __LEAVE_FUNCTION
+}
+
+bool Registry::is_active() {
+  __ENTER_FUNCTION
+    return active_;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+Registry::table_t* Registry::find(uint32_t id) {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < table_count_; ++i) {
+      if (table_[i].id == id) return &table_[i];
+    }
+    return NULL;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+bool Registry::load(table_t* table) {
+  __ENTER_FUNCTION
+    Database* database = new Database(table->id);
+    Assert(database);
+    int64_t modify_time = get_modify_time(table->filename);
+    if (!database->open_from_txt(table->filename) ||
+        (table->prepare && !table->prepare(table->id, database))) {
+      SAFE_DELETE(database); //保留旧表
+      table->modify_time = modify_time;
+      return false;
+    }
+    //索引在这里生成，发布后读者线程不会再修改表
+    database->build_index();
+    Database* old_database = table->database;
+    pap_common_base::util::memory_barrier();
+    table->database = database;
+    pap_common_base::util::memory_barrier();
+    table->modify_time = modify_time;
+    ++(table->version);
+    if (old_database) {
+      synchronize();
+      SAFE_DELETE(old_database);
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Registry::synchronize() {
+  __ENTER_FUNCTION
+    //切换纪元，之后进入的读者只能看到新表，等待之前的读者离开
+    uint32_t parity = epoch_ & 1;
+    pap_common_base::util::memory_barrier();
+    epoch_ = epoch_ + 1;
+    pap_common_base::util::memory_barrier();
+    for (;;) {
+      int32_t count = 0;
+      int32_t i;
+      for (i = 0; i < kRegistryReaderSlotMax; ++i) {
+        count += reader_[i].count[parity];
+      }
+      if (0 == count) break;
+      pap_common_base::util::sleep(1);
+    }
+    pap_common_base::util::memory_barrier();
+  __LEAVE_FUNCTION
+}
+
+void Registry::check_modify() {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < table_count_; ++i) {
+      int64_t modify_time = get_modify_time(table_[i].filename);
+      if (modify_time != 0 && modify_time != table_[i].modify_time) {
+        table_[i].reload = true;
+      }
+    }
+  __LEAVE_FUNCTION
+}
+
+RegistryReader::RegistryReader(Registry &registry) : registry_(registry) {
+  __ENTER_FUNCTION
+    parity_ = 0;
+    slot_ = registry_.read_begin(parity_);
+  __LEAVE_FUNCTION
+}
+
+RegistryReader::~RegistryReader() {
+  __ENTER_FUNCTION
+    registry_.read_end(slot_, parity_);
+  __LEAVE_FUNCTION
+}
+
+const Database* RegistryReader::get(uint32_t id) {
+  __ENTER_FUNCTION
+    return registry_.get(id);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+} //namespace pap_common_file
@@ -32,9 +32,8 @@ FactoryManager::FactoryManager() {
     size_ = serverserver::kLast - serverserver::kFirst; //common for server
 #endif
 #if defined(_PAP_NET_BILLING) || defined(_PAP_NET_LOGIN)
-    size_ += billinglogin::kLast - billinglogin::kFirst - 1;
-    size_ += billing_tologin::kLast - billing_tologin::kFirst - 1;
-    size_ += login_tobilling::kLast - billing_tologin::kFirst - 1;
+    //工厂按包ID直接索引，要放得下最大的ID
+    size_ = login_tobilling::kLast;
 #endif
     Assert(size_ > 0);
     factories_ = new Factory * [size_];
@@ -155,7 +154,9 @@ void FactoryManager::addfactories_for_billinglogin() {
   __ENTER_FUNCTION
     using namespace pap_server_common_net::packets;
     addfactory(new login_tobilling::AskAuthFactory());
+    addfactory(new login_tobilling::AskAuthRpcFactory());
     addfactory(new billing_tologin::ResultAuthFactory());
+    addfactory(new billing_tologin::ResultAuthRpcFactory());
   __LEAVE_FUNCTION
 #endif /* } */
 }
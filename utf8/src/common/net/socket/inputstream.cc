@@ -50,6 +50,15 @@ uint32_t InputStream::read(char* buffer, uint32_t length) {
     return 0;
 }
 
+uint32_t InputStream::write(const char* buffer, uint32_t length) {
+  __ENTER_FUNCTION
+    //输入和输出缓存的环形结构相同，直接按输出的方式追加
+    uint32_t result = vnet_socket_outputstream_write(packet_, buffer, length);
+    return result;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
 bool InputStream::readpacket(packet::Base* packet) {
   __ENTER_FUNCTION
     bool result = false;
@@ -112,6 +121,27 @@ bool InputStream::resize(int32_t size) {
     return false;
 }
 
+bool InputStream::reserve(uint32_t length) {
+  __ENTER_FUNCTION
+    //同OutputStream::reserve，不经过vnet库的扩容
+    uint32_t _reallength = reallength();
+    uint32_t need = _reallength + length + 2;
+    if (packet_->bufferlength >= need) return true;
+    uint32_t bufferlength = packet_->bufferlength << 1;
+    if (bufferlength < need) bufferlength = need;
+    char* buffer = (char*)malloc(sizeof(char) * bufferlength);
+    if (NULL == buffer) return false;
+    if (_reallength > 0) peek(buffer, _reallength);
+    SAFE_FREE(packet_->buffer);
+    packet_->buffer = buffer;
+    packet_->bufferlength = bufferlength;
+    packet_->headlength = 0;
+    packet_->taillength = _reallength;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
 uint32_t InputStream::reallength() {
   __ENTER_FUNCTION
     uint32_t length = 0;
@@ -95,6 +95,28 @@ bool OutputStream::resize(int32_t size) {
     return false;
 }
 
+bool OutputStream::reserve(uint32_t length) {
+  __ENTER_FUNCTION
+    //vnet库里的扩容有问题(链接的是预编译的库)，这里自己换一块更大的缓存，
+    //写入时剩余空间要比写入的长度大
+    uint32_t _reallength = reallength();
+    uint32_t need = _reallength + length + 2;
+    if (packet_->bufferlength >= need) return true;
+    uint32_t bufferlength = packet_->bufferlength << 1;
+    if (bufferlength < need) bufferlength = need;
+    char* buffer = (char*)malloc(sizeof(char) * bufferlength);
+    if (NULL == buffer) return false;
+    if (_reallength > 0) getbuffer(buffer, _reallength);
+    SAFE_FREE(packet_->buffer);
+    packet_->buffer = buffer;
+    packet_->bufferlength = bufferlength;
+    packet_->headlength = 0;
+    packet_->taillength = _reallength;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
 uint32_t OutputStream::reallength() {
   __ENTER_FUNCTION
     uint32_t length = 0;
@@ -131,6 +153,13 @@ int32_t OutputStream::get_keylength() {
   return result;
 }
 
+void OutputStream::getbuffer(char* buffer, uint32_t length) {
+  __ENTER_FUNCTION
+    //只复制不取出，交接连接时使用
+    vnet_socket_inputstream_peek(*packet_, buffer, length);
+  __LEAVE_FUNCTION
+}
+
 Base* OutputStream::getsocket() {
   return socket_;
 }
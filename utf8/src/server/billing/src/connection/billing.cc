@@ -50,6 +50,7 @@ bool Billing::processcommand(bool option) {
       }
       for (;;) { //消费服务器需要及时处理所有消息
 
+        if (is_packet_throttled()) break;
         if (!socket_inputstream_->peek(&packetheader[0], PACKET_HEADERSIZE)) {
           //数据不能填充消息头
           break;
@@ -80,6 +81,7 @@ bool Billing::processcommand(bool option) {
             AssertEx(false, temp);
             return false;
           }
+          if (!audit_packet(packetid, packetsize)) return false;
           //create packet
           packet = g_packetfactory_manager->createpacket(packetid);
           if (NULL == packet) return false;
@@ -91,6 +93,11 @@ bool Billing::processcommand(bool option) {
             g_packetfactory_manager->removepacket(packet);
             return result;
           }
+          if (rpc_dispatch(packet)) { //请求的回应已经交给回调
+            resetkick();
+            g_packetfactory_manager->removepacket(packet);
+            continue;
+          }
           bool needremove = true;
           bool exception = false;
           uint32_t executestatus = 0;
@@ -65,6 +65,23 @@ Server* Pool::create() {
     return NULL;
 }
 
+Server* Pool::create(int16_t id) {
+  __ENTER_FUNCTION
+    Server* connection = NULL;
+    if (id < 0 || id >= kPoolSizeMax) return NULL;
+    lock();
+    if (connection_[id].isempty()) {
+      connection_[id].setempty(false);
+      --count_;
+      connection = &(connection_[id]);
+    }
+    unlock();
+    return connection;
+  __LEAVE_FUNCTION
+    unlock();
+    return NULL;
+}
+
 void Pool::remove(int16_t id) {
   __ENTER_FUNCTION
     lock();
@@ -81,6 +81,10 @@ void Server::setstatus(uint32_t status) {
   status_ = status;
 }
 
+uint32_t Server::getstatus() const {
+  return status_;
+}
+
 bool Server::isvalid() {
   __ENTER_FUNCTION
     bool result = false;
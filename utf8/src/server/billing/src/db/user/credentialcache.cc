@@ -0,0 +1,246 @@
+#include "server/billing/db/user/credentialcache.h"
+#include "common/base/util.h"
+#include "server/common/base/time_manager.h"
+
+namespace db {
+
+namespace user {
+
+CredentialCache::CredentialCache() {
+  __ENTER_FUNCTION
+    uint32_t i;
+    for (i = 0; i < kCredentialCacheShardMax; ++i) {
+      shard_[i].credential = NULL;
+      shard_[i].head = shard_[i].tail = shard_[i].free = -1;
+      shard_[i].hit_count = shard_[i].miss_count = 0;
+    }
+    shard_size_ = 0;
+    cache_time_ = kCredentialCacheTime;
+    notexist_time_ = kCredentialCacheNotExistTime;
+  __LEAVE_FUNCTION
+}
+
+CredentialCache::~CredentialCache() {
+  __ENTER_FUNCTION
+    uint32_t i;
+    for (i = 0; i < kCredentialCacheShardMax; ++i) {
+      SAFE_DELETE_ARRAY(shard_[i].credential);
+    }
+  __LEAVE_FUNCTION
+}
+
+bool CredentialCache::init(uint32_t capacity, 
+                           uint32_t cache_time, 
+                           uint32_t notexist_time) {
+  __ENTER_FUNCTION
+    shard_size_ = static_cast<int32_t>(
+        (capacity + kCredentialCacheShardMax - 1) / kCredentialCacheShardMax);
+    if (shard_size_ <= 0) return false;
+    cache_time_ = cache_time;
+    notexist_time_ = notexist_time;
+    uint32_t i;
+    for (i = 0; i < kCredentialCacheShardMax; ++i) {
+      shard_t* shard = &shard_[i];
+      SAFE_DELETE_ARRAY(shard->credential);
+      shard->credential = new credential_t[shard_size_];
+      Assert(shard->credential);
+      shard->index.init(shard_size_, sizeof(shard->credential[0].account));
+    }
+    cleanup();
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+credential_result_enum CredentialCache::check(const char* account, 
+                                              const char* password) {
+  __ENTER_FUNCTION
+    if (0 == shard_size_ || NULL == account || NULL == password) {
+      return kCredentialMiss;
+    }
+    shard_t* shard = get_shard(account);
+    uint32_t now = static_cast<uint32_t>(g_time_manager->get_ansi_time());
+    credential_result_enum result = kCredentialMiss;
+    shard->lock.lock();
+    credential_t* credential = 
+      static_cast<credential_t*>(shard->index.get(account));
+    if (credential) {
+      int32_t position = static_cast<int32_t>(credential - shard->credential);
+      if (credential->expire_time <= now) {
+        release(shard, position);
+      }
+      else {
+        unlink(shard, position);
+        link(shard, position);
+        if (!credential->exist) {
+          result = kCredentialNotExist;
+        }
+        else {
+          result = password_equal(credential->password, password) ? 
+                   kCredentialRight : 
+                   kCredentialWrong;
+        }
+      }
+    }
+    if (kCredentialMiss == result) {
+      ++(shard->miss_count);
+    }
+    else {
+      ++(shard->hit_count);
+    }
+    shard->lock.unlock();
+    return result;
+  __LEAVE_FUNCTION
+    return kCredentialMiss;
+}
+
+void CredentialCache::set(const char* account, const char* password) {
+  __ENTER_FUNCTION
+    if (0 == shard_size_ || NULL == account || 
+        strlen(account) > ACCOUNTLENGTH_MAX) {
+      return;
+    }
+    shard_t* shard = get_shard(account);
+    uint32_t now = static_cast<uint32_t>(g_time_manager->get_ansi_time());
+    shard->lock.lock();
+    credential_t* credential = 
+      static_cast<credential_t*>(shard->index.get(account));
+    int32_t position = -1;
+    if (credential) {
+      position = static_cast<int32_t>(credential - shard->credential);
+      unlink(shard, position);
+    }
+    else {
+      if (-1 == shard->free) release(shard, shard->tail); //淘汰最久没用的
+      position = shard->free;
+      credential = &(shard->credential[position]);
+      shard->free = credential->next;
+      strncpy(credential->account, account, sizeof(credential->account) - 1);
+      credential->account[sizeof(credential->account) - 1] = '\0';
+      shard->index.add(credential->account, credential);
+    }
+    credential->exist = password != NULL;
+    memset(credential->password, 0, sizeof(credential->password));
+    if (password) {
+      strncpy(credential->password, 
+              password, 
+              sizeof(credential->password) - 1);
+    }
+    credential->expire_time = 
+      now + (credential->exist ? cache_time_ : notexist_time_);
+    link(shard, position);
+    shard->lock.unlock();
+  __LEAVE_FUNCTION
+}
+
+void CredentialCache::remove(const char* account) {
+  __ENTER_FUNCTION
+    if (0 == shard_size_ || NULL == account) return;
+    shard_t* shard = get_shard(account);
+    shard->lock.lock();
+    credential_t* credential = 
+      static_cast<credential_t*>(shard->index.get(account));
+    if (credential) {
+      release(shard, static_cast<int32_t>(credential - shard->credential));
+    }
+    shard->lock.unlock();
+  __LEAVE_FUNCTION
+}
+
+void CredentialCache::cleanup() {
+  __ENTER_FUNCTION
+    uint32_t i;
+    for (i = 0; i < kCredentialCacheShardMax; ++i) {
+      shard_t* shard = &shard_[i];
+      if (NULL == shard->credential) continue;
+      shard->lock.lock();
+      shard->index.cleanup();
+      int32_t j;
+      for (j = 0; j < shard_size_; ++j) {
+        memset(&(shard->credential[j]), 0, sizeof(credential_t));
+        shard->credential[j].previous = -1;
+        shard->credential[j].next = j + 1 < shard_size_ ? j + 1 : -1;
+      }
+      shard->head = shard->tail = -1;
+      shard->free = 0;
+      shard->lock.unlock();
+    }
+  __LEAVE_FUNCTION
+}
+
+void CredentialCache::get_count(uint32_t &hit_count, uint32_t &miss_count) {
+  __ENTER_FUNCTION
+    hit_count = miss_count = 0;
+    uint32_t i;
+    for (i = 0; i < kCredentialCacheShardMax; ++i) {
+      hit_count += shard_[i].hit_count;
+      miss_count += shard_[i].miss_count;
+    }
+  __LEAVE_FUNCTION
+}
+
+CredentialCache::shard_t* CredentialCache::get_shard(const char* account) {
+  uint32_t hash = pap_common_base::util::crc32(
+      account, static_cast<uint32_t>(strlen(account)));
+  return &shard_[hash % kCredentialCacheShardMax];
+}
+
+void CredentialCache::link(shard_t* shard, int32_t position) {
+  credential_t* credential = &(shard->credential[position]);
+  credential->previous = -1;
+  credential->next = shard->head;
+  if (shard->head != -1) shard->credential[shard->head].previous = position;
+  shard->head = position;
+  if (-1 == shard->tail) shard->tail = position;
+}
+
+void CredentialCache::unlink(shard_t* shard, int32_t position) {
+  credential_t* credential = &(shard->credential[position]);
+  if (credential->previous != -1) {
+    shard->credential[credential->previous].next = credential->next;
+  }
+  else {
+    shard->head = credential->next;
+  }
+  if (credential->next != -1) {
+    shard->credential[credential->next].previous = credential->previous;
+  }
+  else {
+    shard->tail = credential->previous;
+  }
+  credential->previous = credential->next = -1;
+}
+
+void CredentialCache::release(shard_t* shard, int32_t position) {
+  credential_t* credential = &(shard->credential[position]);
+  shard->index.remove(credential->account);
+  unlink(shard, position);
+  memset(credential, 0, sizeof(credential_t));
+  credential->previous = -1;
+  credential->next = shard->free;
+  shard->free = position;
+}
+
+bool password_equal(const char* password1, const char* password2) {
+  __ENTER_FUNCTION
+    if (NULL == password1 || NULL == password2) return false;
+    size_t length1 = strlen(password1);
+    size_t length2 = strlen(password2);
+    while (length1 > 0 && ' ' == password1[length1 - 1]) --length1;
+    while (length2 > 0 && ' ' == password2[length2 - 1]) --length2;
+    if (length1 != length2) return false;
+    size_t i;
+    for (i = 0; i < length1; ++i) {
+      if (tolower(static_cast<unsigned char>(password1[i])) != 
+          tolower(static_cast<unsigned char>(password2[i]))) {
+        return false;
+      }
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+} //namespace user
+
+} //namespace db
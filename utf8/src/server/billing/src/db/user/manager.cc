@@ -8,7 +8,7 @@ namespace db {
 namespace user {
 
 Manager::Manager() {
-  //do nothing
+  password_kdf_ = password_kdf_md5;
 }
 
 Manager::~Manager() {
@@ -26,6 +26,7 @@ bool Manager::init() {
     strncpy(user_odbcinterface_->query_.sql_str_, sqlstr_, sizeof(sqlstr_) - 1);
     user_odbcinterface_->clear();
     if (!user_odbcinterface_->execute()) return false;
+    if (!credentialcache_.init()) return false;
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -49,10 +50,12 @@ bool Manager::adduser(const char* name,
                       const char* qq,
                       const char* password2) {
   __ENTER_FUNCTION
-    char encryptpassword[36] = {0};
-    char encryptpassword2[36] = {0};
-    passwordencrypt(password, encryptpassword, sizeof(encryptpassword) - 1);
-    passwordencrypt(password2, encryptpassword2, sizeof(encryptpassword2) - 1);
+    const char* passwords[2] = {password, password2};
+    char encryptpasswords[2][kPasswordEncryptLength + 1];
+    passwordencrypt_batch(passwords, encryptpasswords, 2);
+    const char* encryptpassword = encryptpasswords[0];
+    const char* encryptpassword2 = encryptpasswords[1];
+    credentialcache_.remove(name); //可能缓存了账号不存在
     snprintf(sqlstr_, 
              sizeof(sqlstr_) - 1,
              "call adduser('%s', '%s', '%s', '%s', '%s', '%s', '%s', "
@@ -94,6 +97,7 @@ bool Manager::changepassword(const char* username, const char* password) {
              "call changepassword('%s', '%s')", 
              username, 
              encryptpassword);
+    credentialcache_.remove(username);
     strncpy(user_odbcinterface_->query_.sql_str_,
             sqlstr_,
             sizeof(user_odbcinterface_->query_.sql_str_) - 1);
@@ -110,6 +114,7 @@ bool Manager::deleteuser(const char* username) {
              sizeof(sqlstr_) - 1, 
              "DELETE FROM `users` WHERE name = '%s'", 
              username);
+    credentialcache_.remove(username);
     strncpy(user_odbcinterface_->query_.sql_str_,
             sqlstr_,
             sizeof(user_odbcinterface_->query_.sql_str_) - 1);
@@ -161,20 +166,186 @@ bool Manager::is_haveuser(const char* username) {
 bool Manager::is_realuser(const char* username, const char* password) {
   __ENTER_FUNCTION
     bool result = false;
-    char encryptpassword[36] = {0};
-    passwordencrypt(password, encryptpassword, sizeof(encryptpassword) - 1);
+    char encryptpassword[kPasswordEncryptLength + 1] = {0};
+    passwordencrypt(password, encryptpassword, sizeof(encryptpassword));
+    credential_result_enum cached = 
+      credentialcache_.check(username, encryptpassword);
+    if (cached != kCredentialMiss) return kCredentialRight == cached;
     snprintf(sqlstr_,
              sizeof(sqlstr_) - 1,
-             "SELECT `name` FROM `users`"
-             " WHERE `name` = '%s' AND `password` = '%s'",
-             username,
-             encryptpassword);
+             "SELECT `password` FROM `users` WHERE `name` = '%s'",
+             username);
     strncpy(user_odbcinterface_->query_.sql_str_,
             sqlstr_,
             sizeof(user_odbcinterface_->query_.sql_str_) - 1);
     user_odbcinterface_->clear();
-    if (user_odbcinterface_->execute() && user_odbcinterface_->fetch()) {
-      result = true;
+    if (!user_odbcinterface_->execute()) return false; //数据库错误不缓存
+    if (user_odbcinterface_->fetch()) {
+      const char* rightpassword = user_odbcinterface_->column_[0];
+      credentialcache_.set(username, rightpassword);
+      result = password_equal(rightpassword, encryptpassword);
+    }
+    else {
+      credentialcache_.set(username, NULL);
+    }
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+credential_result_enum Manager::check_credential(const char* username, 
+                                                 const char* password) {
+  __ENTER_FUNCTION
+    char encryptpassword[kPasswordEncryptLength + 1] = {0};
+    passwordencrypt(password, encryptpassword, sizeof(encryptpassword));
+    return credentialcache_.check(username, encryptpassword);
+  __LEAVE_FUNCTION
+    return kCredentialMiss;
+}
+
+bool Manager::load_yuanbao(const char* account, yuanbao_record_t &record) {
+  __ENTER_FUNCTION
+    memset(&record, 0, sizeof(record));
+    strncpy(record.account, account, sizeof(record.account) - 1);
+    snprintf(sqlstr_,
+             sizeof(sqlstr_) - 1,
+             "SELECT `balance`, `daycost`, `costday` FROM `yuanbao`"
+             " WHERE `name` = '%s'",
+             account);
+    strncpy(user_odbcinterface_->query_.sql_str_,
+            sqlstr_,
+            sizeof(user_odbcinterface_->query_.sql_str_) - 1);
+    user_odbcinterface_->clear();
+    if (!user_odbcinterface_->execute()) return false;
+    if (user_odbcinterface_->fetch()) {
+      record.balance = static_cast<uint32_t>(
+          strtoul(user_odbcinterface_->column_[0], NULL, 10));
+      record.day_cost = static_cast<uint32_t>(
+          strtoul(user_odbcinterface_->column_[1], NULL, 10));
+      record.cost_day = static_cast<uint32_t>(
+          strtoul(user_odbcinterface_->column_[2], NULL, 10));
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Manager::save_yuanbao(const yuanbao_record_t* record, int32_t count) {
+  __ENTER_FUNCTION
+    std::vector<std::string> value;
+    int32_t i;
+    for (i = 0; i < count; ++i) {
+      char temp[ACCOUNTLENGTH_MAX + 48] = {0};
+      snprintf(temp, 
+               sizeof(temp) - 1, 
+               "('%s', %u, %u, %u)",
+               record[i].account,
+               record[i].balance,
+               record[i].day_cost,
+               record[i].cost_day);
+      value.push_back(temp);
+    }
+    return execute_values(
+        "INSERT INTO `yuanbao` (`name`, `balance`, `daycost`, `costday`)"
+        " VALUES ",
+        " ON DUPLICATE KEY UPDATE `balance` = VALUES(`balance`),"
+        " `daycost` = VALUES(`daycost`), `costday` = VALUES(`costday`)",
+        value);
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Manager::save_yuanbao_journal(const yuanbao_journal_t* journal, 
+                                   int32_t count) {
+  __ENTER_FUNCTION
+    std::vector<std::string> value;
+    int32_t i;
+    for (i = 0; i < count; ++i) {
+      char temp[ACCOUNTLENGTH_MAX + kYuanbaoKeyLength + 64] = {0};
+      snprintf(temp, 
+               sizeof(temp) - 1, 
+               "('%s', '%s', %d, %u, %u)",
+               journal[i].account,
+               journal[i].key,
+               journal[i].amount,
+               journal[i].balance,
+               journal[i].time);
+      value.push_back(temp);
+    }
+    //写入一半失败后重试时已经写入的会被忽略
+    return execute_values(
+        "INSERT IGNORE INTO `yuanbaojournal`"
+        " (`name`, `requestkey`, `amount`, `balance`, `time`) VALUES ",
+        "",
+        value);
+  __LEAVE_FUNCTION
+    return false;
+}
+
+int32_t Manager::load_yuanbao_journal(uint32_t since, 
+                                      std::vector<yuanbao_journal_t> &result) {
+  __ENTER_FUNCTION
+    snprintf(sqlstr_,
+             sizeof(sqlstr_) - 1,
+             "SELECT `name`, `requestkey`, `amount`, `balance`, `time`"
+             " FROM `yuanbaojournal` WHERE `time` >= %u",
+             since);
+    strncpy(user_odbcinterface_->query_.sql_str_,
+            sqlstr_,
+            sizeof(user_odbcinterface_->query_.sql_str_) - 1);
+    user_odbcinterface_->clear();
+    if (!user_odbcinterface_->execute()) return -1;
+    int32_t count = 0;
+    while (user_odbcinterface_->fetch()) {
+      yuanbao_journal_t journal;
+      memset(&journal, 0, sizeof(journal));
+      strncpy(journal.account, 
+              user_odbcinterface_->column_[0], 
+              sizeof(journal.account) - 1);
+      strncpy(journal.key, 
+              user_odbcinterface_->column_[1], 
+              sizeof(journal.key) - 1);
+      journal.amount = atoi(user_odbcinterface_->column_[2]);
+      journal.balance = static_cast<uint32_t>(
+          strtoul(user_odbcinterface_->column_[3], NULL, 10));
+      journal.time = static_cast<uint32_t>(
+          strtoul(user_odbcinterface_->column_[4], NULL, 10));
+      result.push_back(journal);
+      ++count;
+    }
+    return count;
+  __LEAVE_FUNCTION
+    return -1;
+}
+
+bool Manager::execute_values(const char* head, 
+                             const char* tail, 
+                             const std::vector<std::string> &value) {
+  __ENTER_FUNCTION
+    const uint32_t kTailLength = static_cast<uint32_t>(strlen(tail));
+    const uint32_t kLengthMax = static_cast<uint32_t>(
+        sizeof(user_odbcinterface_->query_.sql_str_) - 1);
+    bool result = true;
+    uint32_t i = 0;
+    while (i < value.size()) {
+      std::string sql(head);
+      uint32_t number = 0;
+      for (; i < value.size(); ++i) {
+        uint32_t length = static_cast<uint32_t>(value[i].length()) + 
+                          (number > 0 ? 2 : 0);
+        if (number > 0 && 
+            sql.length() + length + kTailLength > kLengthMax) break;
+        if (number > 0) sql += ", ";
+        sql += value[i];
+        ++number;
+      }
+      sql += tail;
+      if (sql.length() > kLengthMax) return false; //一条记录也放不下
+      strncpy(user_odbcinterface_->query_.sql_str_,
+              sql.c_str(),
+              sizeof(user_odbcinterface_->query_.sql_str_) - 1);
+      user_odbcinterface_->clear();
+      if (!user_odbcinterface_->execute()) result = false;
     }
     return result;
   __LEAVE_FUNCTION
@@ -183,9 +354,45 @@ bool Manager::is_realuser(const char* username, const char* password) {
 
 void Manager::passwordencrypt(const char* in, char* out, uint8_t length) {
   __ENTER_FUNCTION
-    const char* prefix = "0x";
-    pap_common_base::MD5 MD5ofpassword(in);
-    snprintf(out, length, "%s%s", prefix, MD5ofpassword.md5().c_str());
+    char result[1][kPasswordEncryptLength + 1];
+    passwordencrypt_batch(&in, result, 1);
+    snprintf(out, length, "%s", result[0]);
+  __LEAVE_FUNCTION
+}
+
+void Manager::passwordencrypt_batch(const char* const* in, 
+                                    char (*out)[kPasswordEncryptLength + 1], 
+                                    int32_t count) {
+  __ENTER_FUNCTION
+    if (count <= 0) return;
+    password_kdf_(in, out, count);
+  __LEAVE_FUNCTION
+}
+
+void Manager::set_password_kdf(password_kdf_function function) {
+  __ENTER_FUNCTION
+    password_kdf_ = function ? function : password_kdf_md5;
+  __LEAVE_FUNCTION
+}
+
+void Manager::password_kdf_md5(const char* const* password, 
+                               char (*out)[kPasswordEncryptLength + 1], 
+                               int32_t count) {
+  __ENTER_FUNCTION
+    const int32_t kBatchMax = 16;
+    uint32_t length[kBatchMax];
+    char digest[kBatchMax][pap_common_base::kMD5HexLength + 1];
+    int32_t i, j;
+    for (i = 0; i < count; i += kBatchMax) {
+      int32_t number = count - i < kBatchMax ? count - i : kBatchMax;
+      for (j = 0; j < number; ++j) {
+        length[j] = static_cast<uint32_t>(strlen(password[i + j]));
+      }
+      pap_common_base::md5_hex_multi(password + i, length, digest, number);
+      for (j = 0; j < number; ++j) {
+        snprintf(out[i + j], kPasswordEncryptLength + 1, "0x%s", digest[j]);
+      }
+    }
   __LEAVE_FUNCTION
 }
 
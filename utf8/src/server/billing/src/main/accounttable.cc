@@ -1,33 +1,56 @@
 #include "server/billing/main/accounttable.h"
-#include "common/file/database.h"
+#include "common/file/registry.h"
+#include "server/common/base/log.h"
 
 AccountTable g_accounttable;
 
-bool AccountTable::init() {
+//每次载入新表时调用，按用户名建立哈希索引
+bool account_table_prepare(uint32_t id, pap_common_file::Database* database) {
   __ENTER_FUNCTION
-    bool result = false;
-    pap_common_file::Database account_dbfile(0);
-    result = account_dbfile.open_from_txt("./config/account.txt");
-    if (!result) return false;
-    int32_t tablecount = account_dbfile.get_record_number();
-    if (tablecount <= 0) return false;
-    int32_t i;
-    for (i = 0; i < tablecount; ++i) {
-      strmap_[account_dbfile.search_position(i, 0)->string_value] = 
-        account_dbfile.search_position(i, 1)->string_value;
+    USE_PARAM(id);
+    if (database->get_record_number() <= 0 || 
+        database->get_field_number() < 2) {
+      return false;
+    }
+    if (database->declare_index(pap_common_file::Database::kIndexHash, 0) < 0) {
+      return false;
+    }
+    if (g_log) {
+      g_log->save_log("billing", 
+                      "account table loaded, record: %d", 
+                      database->get_record_number());
     }
     return true;
   __LEAVE_FUNCTION
     return false;
 }
 
+bool AccountTable::init() {
+  __ENTER_FUNCTION
+    bool result = g_table_registry.add(kAccountTableId, 
+                                       "./config/account.txt", 
+                                       account_table_prepare);
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
 bool AccountTable::check(const char* username, const char* password) {
   __ENTER_FUNCTION  
     bool result = false;
     Assert(username);
-    const char* rightpassword = strmap_[username].c_str();
-    if (NULL == rightpassword) return false;
     Assert(password);
+    //读取期间表不会被释放，重载时也不需要加锁
+    pap_common_file::RegistryReader reader(g_table_registry);
+    const pap_common_file::Database* account_dbfile = 
+      reader.get(kAccountTableId);
+    if (NULL == account_dbfile) return false;
+    pap_common_file::Database::field_data key(username);
+    const pap_common_file::Database::field_data* record = 
+      account_dbfile->search_first_column_equal(0, key);
+    if (NULL == record) return false;
+    const char* rightpassword = record[1].string_value;
+    if (NULL == rightpassword) return false;
     result = 0 == strcmp(password, rightpassword);
     return result;
   __LEAVE_FUNCTION
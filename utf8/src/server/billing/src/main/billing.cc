@@ -1,5 +1,9 @@
 #include "server/billing/main/billing.h"
 #include "server/billing/main/accounttable.h"
+#include "server/billing/main/ratelimiter.h"
+#include "server/billing/main/loginqueue.h"
+#include "server/billing/main/yuanbaoledger.h"
+#include "server/billing/main/handoff.h"
 #include "server/billing/connection/pool.h"
 #include "server/billing/main/servermanager.h"
 #include "server/billing/db/user/manager.h"
@@ -7,6 +11,8 @@
 #include "server/common/base/log.h"
 #include "server/common/base/config.h"
 #include "common/net/packet/factorymanager.h"
+#include "common/file/registry.h"
+#include "common/base/util.h"
 
 #if defined(__WINDOWS__)
 #include "common/sys/minidump.h"
@@ -14,6 +20,8 @@ const char* g_dump_exename = "billing";
 #endif
 
 Billing g_billing;
+//-handoffʱӾɽ̽ӹ
+static bool g_handoff_start = false;
 
 int32_t main(int32_t argc, char* argv[]) {
   using namespace pap_server_common_base;
@@ -38,6 +46,7 @@ int32_t main(int32_t argc, char* argv[]) {
         if (0 == strcmp(argv[i],"-retryassert")) g_command_assert = 2;
         if (0 == strcmp(argv[i],"-ignoremessagebox")) 
           g_command_ignore_message_box = true;
+        if (0 == strcmp(argv[i],"-handoff")) g_handoff_start = true;
       }
     }
     bool result = false;
@@ -106,11 +115,29 @@ bool Billing::init() {
     Assert(result);
     g_log->save_log("billing", "new managers...success!");
 
+    if (g_handoff_start) {
+      //ɽ֮̽ǰѾдݣ֮
+      g_log->save_log("billing", "start receive handoff ...");
+      result = g_handoff.receive(kHandoffFile);
+      if (!result) return false;
+      g_log->save_log("billing", "receive handoff...success!");
+    }
+
     g_log->save_log("billing", "start init managers ...");
     result = init_staticmanager();
     Assert(result);
     g_log->save_log("billing", "init managers...success!");
 
+    if (g_handoff_start) {
+      result = g_handoff.confirm();
+      if (!result) return false;
+      g_log->save_log("billing", "confirm handoff...success!");
+    }
+
+    //Ϊһʧʱֻǲܽ
+    if (g_handoff.listen(kHandoffFile)) 
+      g_log->save_log("billing", "g_handoff.listen()...success!");
+
     return result;
   __LEAVE_FUNCTION
     return false;
@@ -173,6 +200,30 @@ bool Billing::init_staticmanager() {
     result = g_accounttable.init();
     Assert(result);
     g_log->save_log("billing", "g_accounttable.init()...success!");
+
+    result = g_ip_ratelimiter.init(kIpRateLimiterSize, 
+                                   kIpRateLimiterRate, 
+                                   kIpRateLimiterBurst) &&
+             g_account_ratelimiter.init(kAccountRateLimiterSize,
+                                        kAccountRateLimiterRate,
+                                        kAccountRateLimiterBurst) &&
+             g_accept_ratelimiter.init(kAcceptRateLimiterSize,
+                                       kAcceptRateLimiterRate,
+                                       kAcceptRateLimiterBurst);
+    Assert(result);
+    g_log->save_log("billing", "ratelimiter init...success!");
+
+    result = g_loginqueue.init();
+    Assert(result);
+    g_log->save_log("billing", "g_loginqueue.init()...success!");
+
+    result = g_yuanbao_ledger.init(
+        static_cast<uint32_t>(g_time_manager->get_ansi_time()));
+    Assert(result);
+    g_log->save_log("billing", "g_yuanbao_ledger.init()...success!");
+
+    g_table_registry.start();
+    g_log->save_log("billing", "g_table_registry.start()...success!");
     
     result = g_servermanager->init();
     Assert(result);
@@ -182,6 +233,10 @@ bool Billing::init_staticmanager() {
     Assert(result);
     g_log->save_log("billing", "g_connectionpool->init()...success!");
 
+    result = g_servermanager->receive_handoff();
+    Assert(result);
+    g_log->save_log("billing", "g_servermanager->receive_handoff()...success!");
+
     result = g_packetfactory_manager->init();
     Assert(result);
     g_log->save_log("billing", "g_packetfactory_manager->init()...success!");
@@ -195,6 +250,16 @@ bool Billing::release_staticmanager() {
   __ENTER_FUNCTION
     using namespace pap_server_common_base;
 
+    g_yuanbao_ledger.flush(
+        static_cast<uint32_t>(g_time_manager->get_ansi_time()));
+    Log::save_log("billing", "g_yuanbao_ledger flush...success!");
+
+    g_table_registry.stop();
+    while (pap_common_sys::Thread::kRunning == g_table_registry.get_status()) {
+      pap_common_base::util::sleep(10);
+    }
+    Log::save_log("billing", "g_table_registry stop...success!");
+
     SAFE_DELETE(g_log);
     Log::save_log("billing", "g_log release...success!");
 
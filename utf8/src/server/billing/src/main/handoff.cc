@@ -0,0 +1,407 @@
+#include "server/billing/main/handoff.h"
+#include "server/common/base/log.h"
+#include "common/lib/vnet/vnet.hpp"
+
+#if defined(__LINUX__)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+Handoff g_handoff;
+
+#if defined(__LINUX__)
+//阻塞读写，超时后当作对方已经不在
+static void set_timeout(int32_t socketid, uint32_t milliseconds) {
+  struct timeval timeout;
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+  setsockopt(socketid, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(socketid, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static bool get_address(const char* filename, struct sockaddr_un &address) {
+  memset(&address, 0, sizeof(address));
+  if (NULL == filename || strlen(filename) >= sizeof(address.sun_path))
+    return false;
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, filename, sizeof(address.sun_path) - 1);
+  return true;
+}
+#endif
+
+Handoff::Handoff() {
+  __ENTER_FUNCTION
+    listen_socketid_ = SOCKET_INVALID;
+    peer_socketid_ = SOCKET_INVALID;
+    server_socketid_ = SOCKET_INVALID;
+    memset(&head_, 0, sizeof(head_));
+    done_ = false;
+  __LEAVE_FUNCTION
+}
+
+Handoff::~Handoff() {
+  __ENTER_FUNCTION
+    //本地套接字的文件可能已经属于新进程，不删除
+    close_peer();
+#if defined(__LINUX__)
+    if (listen_socketid_ != SOCKET_INVALID) ::close(listen_socketid_);
+#endif
+    listen_socketid_ = SOCKET_INVALID;
+  __LEAVE_FUNCTION
+}
+
+bool Handoff::listen(const char* filename) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (listen_socketid_ != SOCKET_INVALID) return true;
+    struct sockaddr_un address;
+    if (!get_address(filename, address)) return false;
+    int32_t socketid = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketid < 0) return false;
+    unlink(filename); //上一个进程留下的
+    if (::bind(socketid,
+               reinterpret_cast<struct sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(socketid, 1) != 0 ||
+        fcntl(socketid, F_SETFL, fcntl(socketid, F_GETFL) | O_NONBLOCK) != 0) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "Handoff::listen(%s) failed, errno: %d",
+                           filename,
+                           errno);
+      ::close(socketid);
+      return false;
+    }
+    listen_socketid_ = socketid;
+    return true;
+#else
+    USE_PARAM(filename);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::is_requested() {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (done_) return false;
+    if (peer_socketid_ != SOCKET_INVALID) return true;
+    if (SOCKET_INVALID == listen_socketid_) return false;
+    int32_t socketid = ::accept(listen_socketid_, NULL, NULL);
+    if (socketid < 0) return false;
+    //accept得到的句柄是阻塞的，新进程连上后马上发版本，不是交接的连接
+    //只会让主循环停一下
+    set_timeout(socketid, kHandoffRequestTime);
+    peer_socketid_ = socketid;
+    uint32_t version = 0;
+    if (!receive_all(&version, sizeof(version)) || version != kHandoffVersion) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "Handoff::is_requested() version: %u, need: %u",
+                           version,
+                           kHandoffVersion);
+      close_peer();
+      return false;
+    }
+    set_timeout(socketid, kHandoffWaitTime * 1000);
+    return true;
+#else
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::send_head(int32_t socketid, const head_t &head) {
+  __ENTER_FUNCTION
+    return send_socket(&head, sizeof(head), socketid);
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::send_connection(const connection_t &connection,
+                              int32_t socketid,
+                              const char* buffer) {
+  __ENTER_FUNCTION
+    if (!send_socket(&connection, sizeof(connection), socketid)) return false;
+    uint32_t length = connection.input_length + connection.output_length;
+    return 0 == length || send_all(buffer, length);
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::wait_confirm() {
+  __ENTER_FUNCTION
+    //新进程确认以后再回应，新进程没有收到回应时不会开始服务
+    uint8_t flag = 0;
+    if (!receive_all(&flag, sizeof(flag)) || flag != 1) return false;
+    if (!send_all(&flag, sizeof(flag))) return false;
+    done_ = true;
+    close_peer();
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Handoff::cancel() {
+  close_peer();
+}
+
+bool Handoff::is_done() const {
+  return done_;
+}
+
+bool Handoff::receive(const char* filename) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    struct sockaddr_un address;
+    if (!get_address(filename, address)) return false;
+    int32_t socketid = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketid < 0) return false;
+    if (::connect(socketid,
+                  reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)) != 0) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "Handoff::receive(%s) connect failed, errno: %d",
+                           filename,
+                           errno);
+      ::close(socketid);
+      return false;
+    }
+    set_timeout(socketid, kHandoffWaitTime * 1000);
+    peer_socketid_ = socketid;
+    uint32_t version = kHandoffVersion;
+    bool result = send_all(&version, sizeof(version)) &&
+                  receive_socket(&head_, sizeof(head_), server_socketid_) &&
+                  kHandoffVersion == head_.version &&
+                  head_.count <= kHandoffConnectionMax;
+    uint32_t i;
+    for (i = 0; result && i < head_.count; ++i) {
+      record_t record;
+      record.socketid = SOCKET_INVALID;
+      result = receive_socket(&record.connection,
+                              sizeof(record.connection),
+                              record.socketid);
+      if (!result) break;
+      record_.push_back(record);
+      record_t &_record = record_.back();
+      _record.connection.host[sizeof(_record.connection.host) - 1] = '\0';
+      if (_record.connection.input_length > kHandoffBufferMax ||
+          _record.connection.output_length > kHandoffBufferMax) {
+        result = false;
+        break;
+      }
+      uint32_t length =
+        _record.connection.input_length + _record.connection.output_length;
+      if (0 == length) continue;
+      _record.buffer.resize(length);
+      result = receive_all(&_record.buffer[0], length);
+    }
+    if (!result) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "Handoff::receive(%s) failed, connection: %u/%u",
+                           filename,
+                           static_cast<uint32_t>(record_.size()),
+                           head_.count);
+      close_received();
+      close_peer();
+      return false;
+    }
+    g_log->fast_save_log(kBillingLogFile,
+                         "Handoff::receive(%s) success, connection: %u",
+                         filename,
+                         head_.count);
+    return true;
+#else
+    USE_PARAM(filename);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+int32_t Handoff::get_listen_socketid() const {
+  return server_socketid_;
+}
+
+const Handoff::head_t &Handoff::get_head() const {
+  return head_;
+}
+
+const std::vector<Handoff::record_t> &Handoff::get_record() const {
+  return record_;
+}
+
+bool Handoff::confirm() {
+  __ENTER_FUNCTION
+    if (SOCKET_INVALID == peer_socketid_) return false;
+    uint8_t flag = 1;
+    bool result = send_all(&flag, sizeof(flag)) &&
+                  receive_all(&flag, sizeof(flag)) &&
+                  1 == flag;
+    close_peer();
+    //句柄已经属于连接，这里只丢掉记录
+    record_.clear();
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::send_socket(const void* data,
+                          uint32_t length,
+                          int32_t socketid) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (SOCKET_INVALID == peer_socketid_ || 0 == length) return false;
+    struct msghdr message;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(int32_t))];
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    iov.iov_base = const_cast<void*>(data);
+    iov.iov_len = length;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int32_t));
+    memcpy(CMSG_DATA(cmsg), &socketid, sizeof(socketid));
+    ssize_t result = -1;
+    do {
+      result = sendmsg(peer_socketid_, &message, MSG_NOSIGNAL);
+    } while (result < 0 && EINTR == errno);
+    if (result <= 0) return false;
+    return send_all(static_cast<const char*>(data) + result,
+                    length - static_cast<uint32_t>(result));
+#else
+    USE_PARAM(data);
+    USE_PARAM(length);
+    USE_PARAM(socketid);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::receive_socket(void* data, uint32_t length, int32_t &socketid) {
+  __ENTER_FUNCTION
+    socketid = SOCKET_INVALID;
+#if defined(__LINUX__)
+    if (SOCKET_INVALID == peer_socketid_ || 0 == length) return false;
+    struct msghdr message;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(int32_t))];
+    memset(&message, 0, sizeof(message));
+    memset(control, 0, sizeof(control));
+    iov.iov_base = data;
+    iov.iov_len = length;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t result = -1;
+    do {
+      result = recvmsg(peer_socketid_, &message, 0);
+    } while (result < 0 && EINTR == errno);
+    if (result <= 0) return false;
+    struct cmsghdr* cmsg = NULL;
+    for (cmsg = CMSG_FIRSTHDR(&message);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR(&message, cmsg)) {
+      if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+        memcpy(&socketid, CMSG_DATA(cmsg), sizeof(socketid));
+      }
+    }
+    if (SOCKET_INVALID == socketid) return false;
+    if (message.msg_flags & MSG_CTRUNC) {
+      ::close(socketid);
+      socketid = SOCKET_INVALID;
+      return false;
+    }
+    if (!receive_all(static_cast<char*>(data) + result,
+                     length - static_cast<uint32_t>(result))) {
+      ::close(socketid);
+      socketid = SOCKET_INVALID;
+      return false;
+    }
+    return true;
+#else
+    USE_PARAM(data);
+    USE_PARAM(length);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::send_all(const void* data, uint32_t length) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    const char* buffer = static_cast<const char*>(data);
+    while (length > 0) {
+      ssize_t result = send(peer_socketid_, buffer, length, MSG_NOSIGNAL);
+      if (result < 0 && EINTR == errno) continue;
+      if (result <= 0) return false;
+      buffer += result;
+      length -= static_cast<uint32_t>(result);
+    }
+    return true;
+#else
+    USE_PARAM(data);
+    USE_PARAM(length);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Handoff::receive_all(void* data, uint32_t length) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    char* buffer = static_cast<char*>(data);
+    while (length > 0) {
+      ssize_t result = recv(peer_socketid_, buffer, length, 0);
+      if (result < 0 && EINTR == errno) continue;
+      if (result <= 0) return false;
+      buffer += result;
+      length -= static_cast<uint32_t>(result);
+    }
+    return true;
+#else
+    USE_PARAM(data);
+    USE_PARAM(length);
+    return false;
+#endif
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Handoff::close_peer() {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (peer_socketid_ != SOCKET_INVALID) ::close(peer_socketid_);
+#endif
+    peer_socketid_ = SOCKET_INVALID;
+  __LEAVE_FUNCTION
+}
+
+void Handoff::close_received() {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (server_socketid_ != SOCKET_INVALID) ::close(server_socketid_);
+    uint32_t i;
+    for (i = 0; i < record_.size(); ++i) {
+      if (record_[i].socketid != SOCKET_INVALID) ::close(record_[i].socketid);
+    }
+#endif
+    server_socketid_ = SOCKET_INVALID;
+    record_.clear();
+  __LEAVE_FUNCTION
+}
@@ -0,0 +1,243 @@
+#include "server/billing/main/loginqueue.h"
+#include "server/billing/main/accounttable.h"
+#include "server/billing/db/user/manager.h"
+#include "server/billing/connection/pool.h"
+#include "server/common/base/config.h"
+#include "server/common/base/log.h"
+#include "server/common/net/packets/billing_tologin/resultauth.h"
+#include "common/base/util.h"
+
+LoginQueue g_loginqueue;
+
+LoginQueue::LoginQueue() {
+  __ENTER_FUNCTION
+    memset(lane_, 0, sizeof(lane_));
+    memset(recent_, 0, sizeof(recent_));
+    capacity_ = 0;
+    admit_token_ = 0;
+    last_time_ = 0;
+    log_time_ = 0;
+  __LEAVE_FUNCTION
+}
+
+LoginQueue::~LoginQueue() {
+  __ENTER_FUNCTION
+    int32_t i;
+    for (i = 0; i < kLaneMax; ++i) {
+      SAFE_DELETE_ARRAY(lane_[i].request);
+    }
+  __LEAVE_FUNCTION
+}
+
+bool LoginQueue::init(uint32_t capacity) {
+  __ENTER_FUNCTION
+    if (0 == capacity) return false;
+    capacity_ = capacity;
+    int32_t i;
+    for (i = 0; i < kLaneMax; ++i) {
+      SAFE_DELETE_ARRAY(lane_[i].request);
+      lane_[i].request = new request_t[capacity_];
+      Assert(lane_[i].request);
+      lane_[i].head = lane_[i].tail = 0;
+    }
+    memset(recent_, 0, sizeof(recent_));
+    admit_token_ = 0;
+    last_time_ = log_time_ = 0;
+    config_cache_.init();
+    config_cache_.tick();
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool LoginQueue::admit_cached(const request_t &request, uint32_t now) {
+  __ENTER_FUNCTION
+    bool right = g_accounttable.check(request.account, request.password);
+    if (!right) {
+      if (NULL == g_user_dbmanager) return false;
+      db::user::credential_result_enum cached = 
+        g_user_dbmanager->check_credential(request.account, 
+                                           request.password);
+      if (db::user::kCredentialMiss == cached) return false;
+      right = db::user::kCredentialRight == cached;
+    }
+    send_result(request, right, now);
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+uint32_t LoginQueue::push(const request_t &request, uint32_t now) {
+  __ENTER_FUNCTION
+    if (0 == capacity_) return 0;
+    lane_enum lane = is_relogin(request.account, now) ? 
+                     kLaneRelogin : 
+                     kLaneNormal;
+    lane_t* _lane = &lane_[lane];
+    if (_lane->tail - _lane->head >= capacity_) return 0;
+    request_t* _request = &(_lane->request[_lane->tail % capacity_]);
+    *_request = request;
+    _request->time = now;
+    ++(_lane->tail);
+    uint32_t position = _lane->tail - _lane->head;
+    if (kLaneNormal == lane) {
+      position += lane_[kLaneRelogin].tail - lane_[kLaneRelogin].head;
+    }
+    return position;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+void LoginQueue::tick(uint32_t now) {
+  __ENTER_FUNCTION
+    if (0 == capacity_) return;
+    config_cache_.tick();
+    uint32_t turn_count = get_turn_count();
+    uint32_t size = get_size();
+    uint32_t count = size;
+    if (turn_count > 0) {
+      //令牌按时间累积，最多一秒的量，和心跳频率无关
+      uint32_t elapsed = 0 == last_time_ ? 0 : now - last_time_;
+      if (elapsed > 1000) elapsed = 1000;
+      admit_token_ += elapsed * turn_count;
+      if (admit_token_ > turn_count * 1000) admit_token_ = turn_count * 1000;
+      if (0 == size) admit_token_ = turn_count * 1000; //空闲时不需要排队
+      count = admit_token_ / 1000;
+      if (count > size) count = size;
+      admit_token_ -= count * 1000;
+    }
+    last_time_ = now;
+    uint32_t i;
+    for (i = 0; i < count; ++i) {
+      lane_t* lane = lane_[kLaneRelogin].tail != lane_[kLaneRelogin].head ?
+                     &lane_[kLaneRelogin] : 
+                     &lane_[kLaneNormal];
+      request_t request = lane->request[lane->head % capacity_];
+      ++(lane->head);
+      admit(request, now);
+    }
+    size = get_size();
+    if (size > 0 && now - log_time_ >= kLoginQueueLogTime) {
+      log_time_ = now;
+      g_log->fast_save_log(kBillingLogFile,
+                           "LoginQueue::tick relogin: %u, normal: %u, "
+                           "turn: %u, wait: %u",
+                           lane_[kLaneRelogin].tail - lane_[kLaneRelogin].head,
+                           lane_[kLaneNormal].tail - lane_[kLaneNormal].head,
+                           turn_count,
+                           get_wait_time(size));
+    }
+  __LEAVE_FUNCTION
+}
+
+void LoginQueue::flush(uint32_t now) {
+  __ENTER_FUNCTION
+    if (0 == capacity_) return;
+    uint32_t i;
+    for (i = 0; i < kLaneMax; ++i) {
+      lane_t* lane = &lane_[i];
+      while (lane->head != lane->tail) {
+        request_t request = lane->request[lane->head % capacity_];
+        ++(lane->head);
+        admit(request, now);
+      }
+    }
+    last_time_ = now;
+  __LEAVE_FUNCTION
+}
+
+uint32_t LoginQueue::get_size() const {
+  return (lane_[kLaneRelogin].tail - lane_[kLaneRelogin].head) +
+         (lane_[kLaneNormal].tail - lane_[kLaneNormal].head);
+}
+
+uint32_t LoginQueue::get_wait_time(uint32_t position) const {
+  __ENTER_FUNCTION
+    uint32_t turn_count = get_turn_count();
+    if (0 == turn_count) return 0;
+    return static_cast<uint32_t>(
+        static_cast<uint64_t>(position) * 1000 / turn_count);
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+bool LoginQueue::is_relogin(const char* account, uint32_t now) const {
+  __ENTER_FUNCTION
+    const pap_server_common_base::config_snapshot_t* snapshot = 
+      config_cache_.get();
+    if (NULL == snapshot) return false;
+    const pap_server_common_base::login_queue_setting_t &login_queue = 
+      snapshot->config_info.login_queue;
+    if (!login_queue.relogin_limit) return false;
+    uint32_t key = pap_common_base::util::crc32(
+        account, static_cast<uint32_t>(strlen(account)));
+    const recent_t* recent = &recent_[key % kLoginQueueRecentMax];
+    return recent->key == key && recent->time != 0 &&
+           now - recent->time < login_queue.relogin_time;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void LoginQueue::set_login(const char* account, uint32_t now) {
+  __ENTER_FUNCTION
+    uint32_t key = pap_common_base::util::crc32(
+        account, static_cast<uint32_t>(strlen(account)));
+    recent_t* recent = &recent_[key % kLoginQueueRecentMax];
+    recent->key = key;
+    recent->time = 0 == now ? 1 : now;
+  __LEAVE_FUNCTION
+}
+
+void LoginQueue::admit(const request_t &request, uint32_t now) {
+  __ENTER_FUNCTION
+    billingconnection::Server* serverconnection = 
+      g_connectionpool->get(request.connectionid);
+    //排队期间登录服务器断开了，不再验证
+    if (NULL == serverconnection || !serverconnection->isvalid()) return;
+    //账号表里的测试账号优先，其余的走数据库（有验证缓存）
+    bool right = g_accounttable.check(request.account, request.password) ||
+                 (g_user_dbmanager && 
+                  g_user_dbmanager->is_realuser(request.account, 
+                                                request.password));
+    send_result(request, right, now);
+  __LEAVE_FUNCTION
+}
+
+void LoginQueue::send_result(const request_t &request, 
+                             bool right, 
+                             uint32_t now) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_net::packets;
+    using namespace pap_common_game::define::result;
+    billingconnection::Server* serverconnection = 
+      g_connectionpool->get(request.connectionid);
+    if (NULL == serverconnection || !serverconnection->isvalid()) return;
+    if (right) set_login(request.account, now);
+    billing_tologin::ResultAuth message;
+    message.set_account(request.account);
+    message.set_result(right ? login::kSuccess : login::kAuthFail);
+    message.set_playerid(request.playerid);
+    if (request.requestid != 0) {
+      using pap_server_common_net::connection::kRpcResponseFlag;
+      message.set_requestid(request.requestid | kRpcResponseFlag);
+    }
+    message.set_isfatigue(0);
+    message.set_total_onlinetime(0);
+    message.set_isphone_bind(0);
+    message.set_isip_bind(0);
+    message.set_ismibao_bind(0);
+    message.set_ismac_bind(0);
+    message.set_is_realname_bind(0);
+    message.set_is_inputname_bind(0);
+    //交接前一次放行很多，先留够空间，不走vnet库的扩容
+    serverconnection->get_socket_outputstream()->reserve(
+        PACKET_HEADERSIZE + message.getsize());
+    serverconnection->sendpacket(&message);
+  __LEAVE_FUNCTION
+}
+
+uint32_t LoginQueue::get_turn_count() const {
+  const pap_server_common_base::config_snapshot_t* snapshot = 
+    config_cache_.get();
+  return snapshot ? snapshot->config_info.login_queue.turn_player_count : 0;
+}
@@ -0,0 +1,143 @@
+#include "server/billing/main/ratelimiter.h"
+#include "common/base/util.h"
+
+RateLimiter g_ip_ratelimiter;
+RateLimiter g_accept_ratelimiter;
+RateLimiter g_account_ratelimiter;
+
+//点分十进制的IPv4地址转为主机字节序
+static bool parse_ip(const char* str, uint32_t &ip) {
+  ip = 0;
+  uint32_t part = 0;
+  uint32_t digit = 0;
+  uint32_t dot = 0;
+  const char* pointer = str;
+  for (;; ++pointer) {
+    char c = *pointer;
+    if (c >= '0' && c <= '9') {
+      part = part * 10 + (c - '0');
+      if (++digit > 3 || part > 255) return false;
+      continue;
+    }
+    if (0 == digit) return false;
+    ip = (ip << 8) | part;
+    part = digit = 0;
+    if ('.' == c && dot < 3) {
+      ++dot;
+      continue;
+    }
+    return '\0' == c && 3 == dot;
+  }
+}
+
+RateLimiter::RateLimiter() {
+  __ENTER_FUNCTION
+    bucket_ = NULL;
+    mask_ = 0;
+    rate_ = 0;
+    burst_ = 0;
+    reject_count_ = 0;
+  __LEAVE_FUNCTION
+}
+
+RateLimiter::~RateLimiter() {
+  __ENTER_FUNCTION
+    SAFE_DELETE_ARRAY(bucket_);
+  __LEAVE_FUNCTION
+}
+
+bool RateLimiter::init(uint32_t size, uint32_t rate, uint32_t burst) {
+  __ENTER_FUNCTION
+    if (0 == size || 0 == rate || 0 == burst) return false;
+    uint32_t count = kRateLimiterProbeMax;
+    while (count < size) count <<= 1;
+    SAFE_DELETE_ARRAY(bucket_);
+    bucket_ = new bucket_t[count];
+    Assert(bucket_);
+    memset(bucket_, 0, sizeof(bucket_t) * count);
+    mask_ = count - 1;
+    rate_ = rate;
+    burst_ = burst * kRateLimiterTokenUnit;
+    reject_count_ = 0;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool RateLimiter::acquire(uint32_t key, uint32_t now) {
+  __ENTER_FUNCTION
+    if (NULL == bucket_) return true; //没有初始化时不限制
+    if (0 == key) key = 1;
+    uint32_t hash = key * 2654435761U;
+    bucket_t* found = NULL;
+    bucket_t* replace = NULL;
+    uint32_t replace_token = 0;
+    uint32_t i;
+    for (i = 0; i < kRateLimiterProbeMax; ++i) {
+      bucket_t* bucket = &bucket_[(hash + i) & mask_];
+      if (bucket->key == key) {
+        found = bucket;
+        break;
+      }
+      //空位或者令牌最多的（装满的桶和新建的一样）
+      uint32_t token = 0 == bucket->key ? burst_ : get_token(*bucket, now);
+      if (NULL == replace || token > replace_token) {
+        replace = bucket;
+        replace_token = token;
+      }
+    }
+    if (NULL == found) {
+      //附近都是没有恢复的桶时占用令牌最多的一个，被挤掉的键相当于重新开始
+      found = replace;
+      found->key = key;
+      found->token = burst_;
+      found->time = now;
+    }
+    found->token = get_token(*found, now);
+    found->time = now;
+    if (found->token < kRateLimiterTokenUnit) {
+      ++reject_count_;
+      return false;
+    }
+    found->token -= kRateLimiterTokenUnit;
+    return true;
+  __LEAVE_FUNCTION
+    return true;
+}
+
+bool RateLimiter::acquire(const char* key, uint32_t now) {
+  __ENTER_FUNCTION
+    if (NULL == key || 0 == key[0]) return true;
+    uint32_t hash = pap_common_base::util::crc32(
+        key, static_cast<uint32_t>(strlen(key)));
+    return acquire(hash, now);
+  __LEAVE_FUNCTION
+    return true;
+}
+
+bool RateLimiter::acquire_ip(uint32_t ip, uint32_t now) {
+  __ENTER_FUNCTION
+    return acquire(ip, now);
+  __LEAVE_FUNCTION
+    return true;
+}
+
+bool RateLimiter::acquire_ip(const char* ip, uint32_t now) {
+  __ENTER_FUNCTION
+    uint32_t value = 0;
+    if (NULL == ip || !parse_ip(ip, value)) value = 0;
+    return acquire_ip(value, now);
+  __LEAVE_FUNCTION
+    return true;
+}
+
+uint32_t RateLimiter::get_reject_count() const {
+  return reject_count_;
+}
+
+uint32_t RateLimiter::get_token(const bucket_t &bucket, uint32_t now) const {
+  uint32_t elapsed = now - bucket.time; //无符号，毫秒计数回绕也正确
+  if (elapsed >= burst_ / rate_) return burst_; //千分之一令牌/每秒令牌=毫秒
+  uint32_t token = bucket.token + elapsed * rate_;
+  return token > burst_ ? burst_ : token;
+}
@@ -1,5 +1,9 @@
 #include "server/billing/main/servermanager.h"
 #include "server/billing/connection/pool.h"
+#include "server/billing/main/ratelimiter.h"
+#include "server/billing/main/loginqueue.h"
+#include "server/billing/main/yuanbaoledger.h"
+#include "server/billing/main/handoff.h"
 #include "server/common/base/config.h"
 #include "server/common/base/log.h"
 #include "server/common/base/time_manager.h"
@@ -7,6 +11,8 @@
 #include "common/base/util.h"
 #include "common/net/packet/factorymanager.h"
 #include "server/common/net/packets/serverserver/connect.h"
+#include "server/common/net/packets/login_tobilling/askauth.h"
+#include "server/common/net/packets/billing_tologin/resultauth.h"
 
 #if defined(__WINDOWS__)
 #pragma warning(disable : 4127) //why use it? for FD_* functions
@@ -17,6 +23,35 @@
 #define min(a,b) ((a) < (b) ? (a) : (b))
 
 const uint8_t kOneStepAccept = 50;
+const uint32_t kReloadCheckTime = 1000; //检查重载命令文件的间隔(毫秒)
+const char* kConnectTestAccount = "pap_connect_test"; //自连测试的验证帐号
+
+//运维放置reload.cmd后重新载入可以重载的配置，与共享内存的saveall.cmd相同
+static bool check_reload_file() {
+  __ENTER_FUNCTION
+    bool result = true;
+    if (-1 == remove("reload.cmd")) result = false;
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+//对端的IPv4地址(主机字节序)，失败返回0
+static uint32_t get_peer_address(int32_t socketid) {
+  struct sockaddr_in address;
+#if defined(__LINUX__)
+  socklen_t length = sizeof(address);
+#elif defined(__WINDOWS__)
+  int length = sizeof(address);
+#endif
+  memset(&address, 0, sizeof(address));
+  if (getpeername(socketid, 
+                  reinterpret_cast<struct sockaddr*>(&address), 
+                  &length) != 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(ntohl(address.sin_addr.s_addr));
+}
 
 ServerManager* g_servermanager = NULL;
 
@@ -27,6 +62,8 @@ ServerManager::ServerManager() {
     FD_ZERO(&exceptfds_[kSelectFull]);
     maxfd_ = minfd_ = SOCKET_INVALID;
     fdsize_ = 0;
+    config_version_ = 0;
+    reload_checktime_ = 0;
     setactive(true);
     billing_serverconnection_.setid(0);
   __LEAVE_FUNCTION
@@ -40,9 +77,18 @@ ServerManager::~ServerManager() {
 
 bool ServerManager::init() {
   __ENTER_FUNCTION
-    serversocket_ = 
-      new pap_server_common_net::Socket(g_config.billing_info_.port_);
-    Assert(serversocket_);
+    int32_t handoff_socketid = g_handoff.get_listen_socketid();
+    if (handoff_socketid != SOCKET_INVALID) {
+      //旧进程还在侦听这个端口，直接使用交过来的句柄
+      serversocket_ = new pap_server_common_net::Socket();
+      Assert(serversocket_);
+      serversocket_->attach(handoff_socketid);
+    }
+    else {
+      serversocket_ = 
+        new pap_server_common_net::Socket(g_config.billing_info_.port_);
+      Assert(serversocket_);
+    }
     serversocket_->set_nonblocking();
     socketid_ = serversocket_->getid();
     Assert(socketid_ != SOCKET_INVALID);
@@ -56,6 +102,7 @@ bool ServerManager::init() {
     for (i = 0; i < OVER_SERVER_MAX; ++i) {
       serverhash_[i] = ID_INVALID;
     }
+    config_cache_.init();
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -250,6 +297,13 @@ bool ServerManager::accept_newconnection() {
         Assert(false);
         goto EXCEPTION;
       }
+      step = 35;
+      //同一个服务器地址重连太频繁时直接关闭，与玩家IP的限速分开
+      if (!g_accept_ratelimiter.acquire_ip(
+            get_peer_address(socketid),
+            g_time_manager->get_current_time())) {
+        goto EXCEPTION;
+      }
       step = 40;
       result = newconnection->getsocket()->set_nonblocking();
       if (!result) {
@@ -301,6 +355,29 @@ EXCEPTION:
 bool ServerManager::heartbeat() {
   __ENTER_FUNCTION
     uint32_t currenttime = g_time_manager->get_current_time();
+    if (currenttime - reload_checktime_ >= kReloadCheckTime) {
+      reload_checktime_ = currenttime;
+      if (check_reload_file()) {
+        g_config.reload(); //新的快照在下面的config_cache_.tick()中取得
+        g_log->fast_save_log(kBillingLogFile, 
+                             "ServerManager::heartbeat config reload, "
+                             "version: %u", 
+                             g_config.get_version());
+      }
+    }
+    g_loginqueue.tick(currenttime);
+    uint32_t ansitime = static_cast<uint32_t>(g_time_manager->get_ansi_time());
+    g_yuanbao_ledger.tick(ansitime);
+    config_cache_.tick();
+    if (config_cache_.get_version() != config_version_) {
+      //配置重新载入后连接上的统计使用新的周期和阈值
+      config_version_ = config_cache_.get_version();
+      const pap_server_common_base::config_info_t &config_info = 
+        config_cache_.config_info();
+      pap_server_common_net::connection::PacketAudit::set_setting(
+          config_info.time.packet_audit_time,
+          config_info.packet_audit);
+    }
     uint16_t connectioncount = billingconnection::Manager::getcount();
     uint16_t i;
     for (i = 0; i < connectioncount; ++i) {
@@ -316,6 +393,7 @@ bool ServerManager::heartbeat() {
         Assert(false);
       }
     }
+    if (g_handoff.is_requested() && !send_handoff()) g_handoff.cancel();
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -529,6 +607,148 @@ void ServerManager::broadcast(pap_common_net::packet::Base* packet) {
   __LEAVE_FUNCTION
 }
 
+bool ServerManager::send_handoff() {
+  __ENTER_FUNCTION
+    //排队的请求直接放行，回应留在输出缓存里一起交出去
+    g_loginqueue.flush(g_time_manager->get_current_time());
+    uint32_t ansitime = static_cast<uint32_t>(g_time_manager->get_ansi_time());
+    if (!g_yuanbao_ledger.flush(ansitime)) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "ServerManager::send_handoff()"
+                           " g_yuanbao_ledger.flush() failed");
+      return false;
+    }
+    Handoff::head_t head;
+    memset(&head, 0, sizeof(head));
+    head.version = kHandoffVersion;
+    memcpy(head.serverhash, serverhash_, sizeof(head.serverhash));
+    uint16_t connectioncount = billingconnection::Manager::getcount();
+    uint16_t i;
+    for (i = 0; i < connectioncount; ++i) {
+      if (ID_INVALID == connectionids_[i]) continue;
+      ++head.count;
+    }
+    if (!g_handoff.send_head(socketid_, head)) return false;
+    std::vector<char> buffer;
+    for (i = 0; i < connectioncount; ++i) {
+      if (ID_INVALID == connectionids_[i]) continue;
+      billingconnection::Server* serverconnection = NULL;
+      serverconnection = g_connectionpool->get(connectionids_[i]);
+      Assert(serverconnection);
+      pap_common_net::socket::Base* socket = serverconnection->getsocket();
+      pap_common_net::socket::InputStream* inputstream = 
+        serverconnection->get_socket_inputstream();
+      pap_common_net::socket::OutputStream* outputstream = 
+        serverconnection->get_socket_outputstream();
+      Handoff::connection_t connection;
+      memset(&connection, 0, sizeof(connection));
+      connection.id = serverconnection->getid();
+      connection.status = serverconnection->getstatus();
+      strncpy(connection.host, socket->host_, sizeof(connection.host) - 1);
+      connection.port = socket->port_;
+      connection.input_length = inputstream->reallength();
+      connection.output_length = outputstream->reallength();
+      buffer.resize(connection.input_length + connection.output_length + 1);
+      if (connection.input_length > 0)
+        inputstream->peek(&buffer[0], connection.input_length);
+      if (connection.output_length > 0) {
+        outputstream->getbuffer(&buffer[connection.input_length], 
+                                connection.output_length);
+      }
+      if (!g_handoff.send_connection(connection, socket->getid(), &buffer[0]))
+        return false;
+    }
+    if (!g_handoff.wait_confirm()) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "ServerManager::send_handoff()"
+                           " not confirmed, continue");
+      return false;
+    }
+    g_log->fast_save_log(kBillingLogFile,
+                         "ServerManager::send_handoff() success,"
+                         " connection: %u",
+                         head.count);
+    setactive(false);
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool ServerManager::receive_handoff() {
+  __ENTER_FUNCTION
+    if (SOCKET_INVALID == g_handoff.get_listen_socketid()) return true;
+    const Handoff::head_t &head = g_handoff.get_head();
+    memcpy(serverhash_, head.serverhash, sizeof(serverhash_));
+    const std::vector<Handoff::record_t> &record = g_handoff.get_record();
+    uint32_t i;
+    for (i = 0; i < record.size(); ++i) {
+      const Handoff::record_t &_record = record[i];
+      const Handoff::connection_t &connection = _record.connection;
+      billingconnection::Server* serverconnection = 
+        g_connectionpool->create(connection.id);
+      if (NULL == serverconnection) {
+        Assert(false);
+        return false;
+      }
+      serverconnection->cleanup();
+      pap_common_net::socket::Base* socket = serverconnection->getsocket();
+      socket->socketid_ = _record.socketid;
+      strncpy(socket->host_, connection.host, sizeof(socket->host_) - 1);
+      socket->port_ = connection.port;
+      serverconnection->init();
+      serverconnection->setstatus(connection.status);
+      const char* buffer = _record.buffer.empty() ? NULL : &_record.buffer[0];
+      pap_common_net::socket::InputStream* inputstream = 
+        serverconnection->get_socket_inputstream();
+      pap_common_net::socket::OutputStream* outputstream = 
+        serverconnection->get_socket_outputstream();
+      //先按交接的长度留够空间，写入时不会扩容
+      if (!inputstream->reserve(connection.input_length) ||
+          !outputstream->reserve(connection.output_length) ||
+          (connection.input_length > 0 &&
+           inputstream->write(
+             buffer, connection.input_length) != connection.input_length) ||
+          (connection.output_length > 0 &&
+           outputstream->write(
+             buffer + connection.input_length, 
+             connection.output_length) != connection.output_length) ||
+          !addconnection(serverconnection)) {
+        Assert(false);
+        return false;
+      }
+    }
+    g_log->fast_save_log(kBillingLogFile,
+                         "ServerManager::receive_handoff() connection: %u",
+                         static_cast<uint32_t>(record.size()));
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+//自连测试的验证回应，packet为NULL表示超时或连接断开
+static void connect_test_result(
+    pap_server_common_net::connection::Base* connection,
+    uint32_t requestid,
+    pap_common_net::packet::Base* packet,
+    void* data) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_net::packets;
+    USE_PARAM(connection);
+    USE_PARAM(data);
+    int32_t result = -1;
+    if (packet != NULL) {
+      billing_tologin::ResultAuth* resultauth =
+        dynamic_cast<billing_tologin::ResultAuth*>(packet);
+      if (resultauth) result = resultauth->get_result();
+    }
+    g_log->fast_save_log(kBillingLogFile,
+                         "ServerManager::connectserver() requestid: %u,"
+                         " result: %d",
+                         requestid,
+                         result);
+  __LEAVE_FUNCTION
+}
+
 bool ServerManager::connectserver() {
   uint8_t step = 0;
   __ENTER_FUNCTION
@@ -592,6 +812,17 @@ bool ServerManager::connectserver() {
       step = 7;
       Assert(false);
     }
+    { //通过请求表走一次验证，检查请求ID能带回来
+      pap_server_common_net::packets::login_tobilling::AskAuth askauth;
+      askauth.setaccount(kConnectTestAccount);
+      askauth.setip(kServerIp);
+      uint32_t requestid = 
+        billing_serverconnection_.rpc_call(&askauth, connect_test_result, NULL);
+      if (0 == requestid) {
+        step = 8;
+        Assert(false);
+      }
+    }
     g_log->fast_save_log(kBillingLogFile, 
                          "ServerManager::connectserver() is success!");
     return true;
@@ -0,0 +1,401 @@
+#include "server/billing/main/yuanbaoledger.h"
+#include "server/common/base/log.h"
+#include "server/common/base/time_manager.h"
+
+YuanbaoLedger g_yuanbao_ledger;
+
+YuanbaoLedger::YuanbaoLedger() {
+  __ENTER_FUNCTION
+    account_ = NULL;
+    accountmax_ = 0;
+    free_ = NULL;
+    free_number_ = 0;
+    hand_ = 0;
+    result_ = NULL;
+    result_position_ = 0;
+    sequence_ = 0;
+    committed_sequence_ = 0;
+    commit_time_ = 0;
+  __LEAVE_FUNCTION
+}
+
+YuanbaoLedger::~YuanbaoLedger() {
+  __ENTER_FUNCTION
+    SAFE_DELETE_ARRAY(account_);
+    SAFE_DELETE_ARRAY(free_);
+    SAFE_DELETE_ARRAY(result_);
+  __LEAVE_FUNCTION
+}
+
+bool YuanbaoLedger::init(uint32_t now, uint32_t accountmax) {
+  __ENTER_FUNCTION
+    if (0 == accountmax) return false;
+    SAFE_DELETE_ARRAY(account_);
+    SAFE_DELETE_ARRAY(free_);
+    SAFE_DELETE_ARRAY(result_);
+    account_ = new account_t[accountmax];
+    Assert(account_);
+    free_ = new int32_t[accountmax];
+    Assert(free_);
+    memset(account_, 0, sizeof(account_t) * accountmax);
+    uint32_t i;
+    for (i = 0; i < accountmax; ++i) {
+      free_[i] = static_cast<int32_t>(accountmax - 1 - i);
+    }
+    accountmax_ = free_number_ = accountmax;
+    hand_ = 0;
+    account_table_.cleanup();
+    account_table_.init(accountmax, ACCOUNTLENGTH_MAX + 1);
+    result_ = new result_t[kYuanbaoResultMax];
+    Assert(result_);
+    memset(result_, 0, sizeof(result_t) * kYuanbaoResultMax);
+    result_position_ = 0;
+    result_table_.cleanup();
+    result_table_.init(kYuanbaoResultMax, kYuanbaoResultKeyLength + 1);
+    journal_.clear();
+    dirty_.clear();
+    sequence_ = committed_sequence_ = 0;
+    commit_time_ = now;
+    config_cache_.init();
+    config_cache_.tick();
+    if (NULL == g_user_dbmanager) return true;
+    //已经提交的请求重试时不能再执行一次
+    uint32_t since = now > kYuanbaoDedupeTime ? now - kYuanbaoDedupeTime : 0;
+    std::vector<db::user::yuanbao_journal_t> journal;
+    if (g_user_dbmanager->load_yuanbao_journal(since, journal) < 0) {
+      return false;
+    }
+    for (i = 0; i < journal.size(); ++i) {
+      add_result(journal[i].account, 
+                 journal[i].key, 
+                 journal[i].balance, 
+                 0);
+    }
+    g_log->fast_save_log(kBillingLogFile,
+                         "YuanbaoLedger::init() load %u keys",
+                         result_table_.get_count());
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+yuanbao_result_enum YuanbaoLedger::cost(const char* account,
+                                        const char* key,
+                                        uint32_t amount,
+                                        uint32_t now,
+                                        yuanbao_reply_t* reply) {
+  __ENTER_FUNCTION
+    if (0 == amount || amount > 0x7FFFFFFF) return kYuanbaoInvalid;
+    return apply(account, key, -static_cast<int32_t>(amount), now, reply);
+  __LEAVE_FUNCTION
+    return kYuanbaoError;
+}
+
+yuanbao_result_enum YuanbaoLedger::add(const char* account,
+                                       const char* key,
+                                       uint32_t amount,
+                                       uint32_t now,
+                                       yuanbao_reply_t* reply) {
+  __ENTER_FUNCTION
+    if (0 == amount || amount > 0x7FFFFFFF) return kYuanbaoInvalid;
+    return apply(account, key, static_cast<int32_t>(amount), now, reply);
+  __LEAVE_FUNCTION
+    return kYuanbaoError;
+}
+
+yuanbao_result_enum YuanbaoLedger::get_balance(const char* account,
+                                               uint32_t &balance) {
+  __ENTER_FUNCTION
+    balance = 0;
+    if (NULL == account_ || NULL == account) return kYuanbaoInvalid;
+    yuanbao_result_enum result = kYuanbaoSuccess;
+    account_t* _account = get_account(account, result);
+    if (NULL == _account) return result;
+    balance = _account->balance;
+    return kYuanbaoSuccess;
+  __LEAVE_FUNCTION
+    return kYuanbaoError;
+}
+
+uint32_t YuanbaoLedger::get_committed_sequence() const {
+  return committed_sequence_;
+}
+
+void YuanbaoLedger::tick(uint32_t now) {
+  __ENTER_FUNCTION
+    if (NULL == account_) return;
+    config_cache_.tick();
+    if (journal_.empty() && dirty_.empty()) {
+      commit_time_ = now;
+      return;
+    }
+    if (journal_.size() >= kYuanbaoCommitBatch ||
+        now - commit_time_ >= kYuanbaoCommitTime) {
+      flush(now);
+    }
+  __LEAVE_FUNCTION
+}
+
+bool YuanbaoLedger::flush(uint32_t now) {
+  __ENTER_FUNCTION
+    commit_time_ = now;
+    if (NULL == g_user_dbmanager) {
+      committed_sequence_ = sequence_;
+      journal_.clear();
+      uint32_t i;
+      for (i = 0; i < dirty_.size(); ++i) account_[dirty_[i]].dirty = false;
+      dirty_.clear();
+      return true;
+    }
+    //先写日志，日志写入前崩溃最多丢掉还没有回应的请求
+    if (!journal_.empty()) {
+      if (!g_user_dbmanager->save_yuanbao_journal(
+            &journal_[0], static_cast<int32_t>(journal_.size()))) {
+        g_log->fast_save_log(kBillingLogFile,
+                             "YuanbaoLedger::flush() save %u journal failed",
+                             static_cast<uint32_t>(journal_.size()));
+        return false;
+      }
+      journal_.clear();
+      committed_sequence_ = sequence_;
+    }
+    if (dirty_.empty()) return true;
+    std::vector<db::user::yuanbao_record_t> record;
+    record.reserve(dirty_.size());
+    uint32_t i;
+    for (i = 0; i < dirty_.size(); ++i) {
+      account_t* account = &account_[dirty_[i]];
+      db::user::yuanbao_record_t _record;
+      memset(&_record, 0, sizeof(_record));
+      strncpy(_record.account, account->account, sizeof(_record.account) - 1);
+      _record.balance = account->balance;
+      _record.day_cost = account->day_cost;
+      _record.cost_day = account->cost_day;
+      record.push_back(_record);
+    }
+    if (!g_user_dbmanager->save_yuanbao(&record[0],
+                                        static_cast<int32_t>(record.size()))) {
+      g_log->fast_save_log(kBillingLogFile,
+                           "YuanbaoLedger::flush() save %u balance failed",
+                           static_cast<uint32_t>(record.size()));
+      return false;
+    }
+    for (i = 0; i < dirty_.size(); ++i) account_[dirty_[i]].dirty = false;
+    dirty_.clear();
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+uint32_t YuanbaoLedger::get_pending_count() const {
+  return static_cast<uint32_t>(journal_.size());
+}
+
+yuanbao_result_enum YuanbaoLedger::apply(const char* account,
+                                         const char* key,
+                                         int32_t amount,
+                                         uint32_t now,
+                                         yuanbao_reply_t* reply) {
+  __ENTER_FUNCTION
+    if (reply) memset(reply, 0, sizeof(yuanbao_reply_t));
+    if (NULL == account_ || NULL == account || !is_valid_key(key)) {
+      return kYuanbaoInvalid;
+    }
+    if (strlen(account) > ACCOUNTLENGTH_MAX) return kYuanbaoInvalid;
+    result_t* result = find_result(account, key);
+    if (result) {
+      if (reply) {
+        reply->result = kYuanbaoSuccess;
+        reply->balance = result->balance;
+        reply->sequence = result->sequence;
+        reply->duplicate = true;
+      }
+      return kYuanbaoSuccess;
+    }
+    //数据库写不进去时不再接受新的变化，内存和数据库不会差太多
+    if (journal_.size() >= kYuanbaoJournalMax) return kYuanbaoBusy;
+    yuanbao_result_enum _result = kYuanbaoSuccess;
+    account_t* _account = get_account(account, _result);
+    if (NULL == _account) return _result;
+    if (reply) reply->balance = _account->balance;
+    if (amount < 0) {
+      uint32_t cost = static_cast<uint32_t>(-amount);
+      if (_account->balance < cost) return kYuanbaoNotEnough;
+      uint32_t today = g_time_manager ? g_time_manager->get_day_time() : 0;
+      if (_account->cost_day != today) {
+        _account->cost_day = today;
+        _account->day_cost = 0;
+      }
+      uint32_t max_day_cost = get_max_day_cost(); //0为不限制
+      if (max_day_cost != 0 &&
+          (_account->day_cost >= max_day_cost ||
+           cost > max_day_cost - _account->day_cost)) {
+        return kYuanbaoDayLimit;
+      }
+      _account->balance -= cost;
+      _account->day_cost += cost;
+    }
+    else {
+      if (_account->balance > 0xFFFFFFFF - static_cast<uint32_t>(amount)) {
+        return kYuanbaoInvalid;
+      }
+      _account->balance += static_cast<uint32_t>(amount);
+    }
+    //序号为0表示已经提交
+    ++sequence_;
+    if (0 == sequence_) sequence_ = 1;
+    db::user::yuanbao_journal_t journal;
+    memset(&journal, 0, sizeof(journal));
+    strncpy(journal.account, account, sizeof(journal.account) - 1);
+    strncpy(journal.key, key, sizeof(journal.key) - 1);
+    journal.amount = amount;
+    journal.balance = _account->balance;
+    journal.time = now;
+    journal_.push_back(journal);
+    set_dirty(_account);
+    //只记住成功的请求，失败的请求重试时按当时的余额重新计算
+    add_result(account, key, _account->balance, sequence_);
+    if (reply) {
+      reply->result = kYuanbaoSuccess;
+      reply->balance = _account->balance;
+      reply->sequence = sequence_;
+    }
+    return kYuanbaoSuccess;
+  __LEAVE_FUNCTION
+    return kYuanbaoError;
+}
+
+YuanbaoLedger::account_t* YuanbaoLedger::get_account(
+    const char* account,
+    yuanbao_result_enum &result) {
+  __ENTER_FUNCTION
+    result = kYuanbaoSuccess;
+    account_t* _account =
+      reinterpret_cast<account_t*>(account_table_.get(account));
+    if (_account) {
+      _account->visited = true;
+      return _account;
+    }
+    if (strlen(account) > ACCOUNTLENGTH_MAX) {
+      result = kYuanbaoInvalid;
+      return NULL;
+    }
+    db::user::yuanbao_record_t record;
+    memset(&record, 0, sizeof(record));
+    if (g_user_dbmanager && !g_user_dbmanager->load_yuanbao(account, record)) {
+      result = kYuanbaoError;
+      return NULL;
+    }
+    _account = alloc_account();
+    if (NULL == _account) {
+      result = kYuanbaoBusy;
+      return NULL;
+    }
+    memset(_account, 0, sizeof(account_t));
+    strncpy(_account->account, account, sizeof(_account->account) - 1);
+    if (!account_table_.add(_account->account, _account)) {
+      free_[free_number_++] = static_cast<int32_t>(_account - account_);
+      result = kYuanbaoBusy;
+      return NULL;
+    }
+    _account->balance = record.balance;
+    _account->day_cost = record.day_cost;
+    _account->cost_day = record.cost_day;
+    _account->used = true;
+    _account->visited = true;
+    return _account;
+  __LEAVE_FUNCTION
+    result = kYuanbaoError;
+    return NULL;
+}
+
+YuanbaoLedger::account_t* YuanbaoLedger::alloc_account() {
+  __ENTER_FUNCTION
+    if (free_number_ > 0) return &account_[free_[--free_number_]];
+    //时钟算法换出最近没有使用的账号，还没写回的不能换出
+    uint32_t i;
+    for (i = 0; i < accountmax_ * 2; ++i) {
+      account_t* account = &account_[hand_];
+      hand_ = (hand_ + 1) % accountmax_;
+      if (!account->used || account->dirty) continue;
+      if (account->visited) {
+        account->visited = false;
+        continue;
+      }
+      account_table_.remove(account->account);
+      account->used = false;
+      return account;
+    }
+    return NULL;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+YuanbaoLedger::result_t* YuanbaoLedger::find_result(const char* account,
+                                                    const char* key) {
+  __ENTER_FUNCTION
+    char result_key[kYuanbaoResultKeyLength + 1] = {0};
+    get_result_key(account, key, result_key);
+    return reinterpret_cast<result_t*>(result_table_.get(result_key));
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void YuanbaoLedger::add_result(const char* account,
+                               const char* key,
+                               uint32_t balance,
+                               uint32_t sequence) {
+  __ENTER_FUNCTION
+    if (NULL == account || strlen(account) > ACCOUNTLENGTH_MAX) return;
+    if (!is_valid_key(key) || find_result(account, key)) return;
+    //最旧的结果被覆盖，重试的时间不会这么久
+    result_t* result = &result_[result_position_];
+    result_position_ = (result_position_ + 1) & (kYuanbaoResultMax - 1);
+    if (result->used) result_table_.remove(result->key);
+    memset(result, 0, sizeof(result_t));
+    get_result_key(account, key, result->key);
+    result->balance = balance;
+    result->sequence = sequence;
+    result->used = result_table_.add(result->key, result);
+  __LEAVE_FUNCTION
+}
+
+void YuanbaoLedger::get_result_key(const char* account,
+                                   const char* key,
+                                   char* result_key) {
+  __ENTER_FUNCTION
+    snprintf(result_key, kYuanbaoResultKeyLength + 1, "%s|%s", key, account);
+  __LEAVE_FUNCTION
+}
+
+void YuanbaoLedger::set_dirty(account_t* account) {
+  __ENTER_FUNCTION
+    if (account->dirty) return;
+    account->dirty = true;
+    dirty_.push_back(static_cast<int32_t>(account - account_));
+  __LEAVE_FUNCTION
+}
+
+uint32_t YuanbaoLedger::get_max_day_cost() const {
+  const pap_server_common_base::config_snapshot_t* snapshot =
+    config_cache_.get();
+  return snapshot ? snapshot->config_info.yuanbao.max_day_can_cost : 0;
+}
+
+bool YuanbaoLedger::is_valid_key(const char* key) {
+  __ENTER_FUNCTION
+    if (NULL == key || '\0' == key[0]) return false;
+    uint32_t i;
+    for (i = 0; key[i] != '\0'; ++i) {
+      if (i >= db::user::kYuanbaoKeyLength) return false;
+      char c = key[i];
+      if ((c >= '0' && c <= '9') ||
+          (c >= 'a' && c <= 'z') ||
+          (c >= 'A' && c <= 'Z') ||
+          ':' == c || '-' == c || '_' == c) continue;
+      return false;
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
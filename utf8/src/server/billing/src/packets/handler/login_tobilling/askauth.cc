@@ -1,6 +1,9 @@
 #include "server/common/net/packets/login_tobilling/askauth.h"
 #include "server/common/net/packets/billing_tologin/resultauth.h"
 #include "server/billing/connection/server.h"
+#include "server/billing/main/ratelimiter.h"
+#include "server/billing/main/loginqueue.h"
+#include "server/common/base/time_manager.h"
 
 namespace pap_server_common_net {
 
@@ -15,25 +18,39 @@ uint32_t AskAuthHandler::execute(AskAuth* packet,
     using namespace connection;
     Assert(packet);
     Assert(connection);
-    //return success
-    billing_tologin::ResultAuth message;
     char account[ACCOUNTLENGTH_MAX + 1] = {0};
+    char ip[IP_SIZE + 1] = {0};
     packet->getaccount(account, sizeof(account) - 1);
-    message.set_account(account);
-    message.set_result(login::kSuccess);
-    message.set_playerid(packet->get_playerid());
-    message.set_isfatigue(0);
-    message.set_total_onlinetime(0);
-    message.set_isphone_bind(0);
-    message.set_isip_bind(0);
-    message.set_ismibao_bind(0);
-    message.set_ismac_bind(0);
-    message.set_is_realname_bind(0);
-    message.set_is_inputname_bind(0);
-    billingconnection::Server* serverconnection = NULL;
-    serverconnection = dynamic_cast<billingconnection::Server*>(connection);
-    Assert(serverconnection);
-    serverconnection->sendpacket(&message);
+    packet->getip(ip, sizeof(ip));
+    //限速在验证之前，超过的请求不会查询数据库
+    uint32_t now = g_time_manager->get_current_time();
+    bool allow = g_ip_ratelimiter.acquire_ip(ip, now) && 
+                 g_account_ratelimiter.acquire(account, now);
+    if (allow) { //缓存能确定结果时直接返回，否则进入登录队列，心跳时验证
+      LoginQueue::request_t request;
+      memset(&request, 0, sizeof(request));
+      request.connectionid = connection->getid();
+      request.playerid = packet->get_playerid();
+      request.requestid = packet->get_requestid();
+      strncpy(request.account, account, sizeof(request.account) - 1);
+      packet->getpassword(request.password, sizeof(request.password));
+      allow = g_loginqueue.admit_cached(request, now) ||
+              g_loginqueue.push(request, now) > 0;
+    }
+    if (!allow) {
+      billing_tologin::ResultAuth message;
+      message.set_account(account);
+      message.set_result(login::kMustWait);
+      message.set_playerid(packet->get_playerid());
+      if (packet->get_requestid() != 0) {
+        using pap_server_common_net::connection::kRpcResponseFlag;
+        message.set_requestid(packet->get_requestid() | kRpcResponseFlag);
+      }
+      billingconnection::Server* serverconnection = NULL;
+      serverconnection = dynamic_cast<billingconnection::Server*>(connection);
+      Assert(serverconnection);
+      serverconnection->sendpacket(&message);
+    }
     return kPacketExecuteStatusContinue;
   __LEAVE_FUNCTION
     return kPacketExecuteStatusError;
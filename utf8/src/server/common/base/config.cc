@@ -2,6 +2,10 @@
 #include "server/common/base/file_define.h"
 #include "server/common/base/log.h"
 #include "common/file/ini.h"
+#include "common/base/util.h"
+#if defined(_PAP_SHAREMEMORY) || defined(_PAP_WORLD) || defined(_PAP_SERVER)
+#include "server/common/sys/share_memory.h"
+#endif
 
 pap_server_common_base::Config g_config;
 
@@ -29,6 +33,13 @@ config_info_t::config_info_t() {
     time.drop_box_recycle = 60000;
     time.time_change_interval = 150000;
     time.packet_audit_time = 0;
+    packet_audit.throttle_count = 0;
+    packet_audit.kick_count = 0;
+    packet_audit.kick_packet_count = 0;
+    packet_audit.dump = false;
+    login_queue.turn_player_count = 100;
+    login_queue.relogin_limit = false;
+    login_queue.relogin_time = 60000;
     monster.max_count = 20000;
     monster.default_respawn_time = 30000;
     monster.default_position_range = 10;
@@ -273,6 +284,15 @@ share_memory_info_t::share_memory_info_t() {
     encrypt_password = false;
     world_data_save_interval = 1200000;
     human_data_save_interval = 900000;
+    backend_type = 0;
+    huge_page = false;
+    memset(mmap_file_path, '\0', sizeof(mmap_file_path));
+    snprintf(mmap_file_path, sizeof(mmap_file_path) - 1, "%s", "/dev/shm");
+    memset(snapshot_path, '\0', sizeof(snapshot_path));
+    snprintf(snapshot_path, sizeof(snapshot_path) - 1, "%s", ".");
+    journal = false;
+    memset(journal_path, '\0', sizeof(journal_path));
+    snprintf(journal_path, sizeof(journal_path) - 1, "%s", ".");
   __LEAVE_FUNCTION
 }
 
@@ -505,12 +525,88 @@ bool BillingInfo::is_use() {
     return false;
 }
 
+//-- config cache class
+ConfigCache::ConfigCache() {
+  __ENTER_FUNCTION
+    config_ = NULL;
+    snapshot_ = NULL;
+    version_ = 0;
+  __LEAVE_FUNCTION
+}
+
+ConfigCache::~ConfigCache() {
+  __ENTER_FUNCTION
+    release();
+  __LEAVE_FUNCTION
+}
+
+bool ConfigCache::init(Config* config) {
+  __ENTER_FUNCTION
+    config_ = config ? config : &g_config;
+    if (!config_->register_cache(this)) {
+      config_ = NULL;
+      return false;
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void ConfigCache::release() {
+  __ENTER_FUNCTION
+    if (config_) config_->unregister_cache(this);
+    config_ = NULL;
+    snapshot_ = NULL;
+  __LEAVE_FUNCTION
+}
+
+void ConfigCache::tick() {
+  __ENTER_FUNCTION
+    if (!config_) return;
+    const config_snapshot_t* snapshot = config_->get_snapshot();
+    if (snapshot == snapshot_ || NULL == snapshot) return;
+    snapshot_ = snapshot;
+    pap_common_base::util::memory_barrier();
+    version_ = snapshot->version; //写者根据这个判断旧快照是否还在使用
+  __LEAVE_FUNCTION
+}
+
+const config_snapshot_t* ConfigCache::get() const {
+  __ENTER_FUNCTION
+    return snapshot_;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+const config_info_t& ConfigCache::config_info() const {
+  return snapshot_->config_info;
+}
+
+uint32_t ConfigCache::get_version() const {
+  __ENTER_FUNCTION
+    return version_;
+  __LEAVE_FUNCTION
+    return 0;
+}
+//config cache class --
+
 Config::Config() {
-  //do nothing
+  __ENTER_FUNCTION
+    snapshot_ = NULL;
+    cache_count_ = 0;
+    memset(cache_, 0, sizeof(cache_));
+  __LEAVE_FUNCTION
 }
 
 Config::~Config() {
-  //do noting
+  __ENTER_FUNCTION
+    SAFE_DELETE(snapshot_);
+    uint32_t i;
+    for (i = 0; i < retired_snapshot_.size(); ++i) {
+      SAFE_DELETE(retired_snapshot_[i]);
+    }
+    retired_snapshot_.clear();
+  __LEAVE_FUNCTION
 }
 
 bool Config::init() {
@@ -524,6 +620,9 @@ bool Config::init() {
     load_server_info();
     load_scene_info();
     load_copy_scene_info();
+    lock_.lock();
+    publish();
+    lock_.unlock();
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -531,6 +630,8 @@ bool Config::init() {
 
 void Config::reload() {
   __ENTER_FUNCTION
+    //config_info_只在这里修改，读者使用发布后的快照
+    lock_.lock();
     load_config_info_reload();
     load_login_info_reload();
     load_world_info_reload();
@@ -540,6 +641,93 @@ void Config::reload() {
     load_server_info_reload();
     load_scene_info_reload();
     load_copy_scene_info_reload();
+    publish();
+    collect();
+    lock_.unlock();
+  __LEAVE_FUNCTION
+}
+
+const config_snapshot_t* Config::get_snapshot() const {
+  __ENTER_FUNCTION
+    const config_snapshot_t* snapshot = snapshot_;
+    pap_common_base::util::memory_barrier();
+    return snapshot;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+uint32_t Config::get_version() const {
+  __ENTER_FUNCTION
+    const config_snapshot_t* snapshot = get_snapshot();
+    return snapshot ? snapshot->version : 0;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+bool Config::register_cache(ConfigCache* cache) {
+  __ENTER_FUNCTION
+    bool result = false;
+    lock_.lock();
+    if (cache_count_ < kConfigCacheMax) {
+      cache_[cache_count_++] = cache;
+      result = true;
+    }
+    lock_.unlock();
+    cache->tick();
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Config::unregister_cache(ConfigCache* cache) {
+  __ENTER_FUNCTION
+    lock_.lock();
+    int32_t i;
+    for (i = 0; i < cache_count_; ++i) {
+      if (cache_[i] == cache) {
+        cache_[i] = cache_[--cache_count_];
+        cache_[cache_count_] = NULL;
+        break;
+      }
+    }
+    lock_.unlock();
+  __LEAVE_FUNCTION
+}
+
+void Config::publish() {
+  __ENTER_FUNCTION
+    config_snapshot_t* snapshot = new config_snapshot_t;
+    Assert(snapshot);
+    config_snapshot_t* old_snapshot = snapshot_;
+    snapshot->version = old_snapshot ? old_snapshot->version + 1 : 1;
+    snapshot->config_info = config_info_;
+    pap_common_base::util::memory_barrier();
+    snapshot_ = snapshot;
+    pap_common_base::util::memory_barrier();
+    if (old_snapshot) retired_snapshot_.push_back(old_snapshot);
+    Log::save_log("config", "publish config snapshot version: %u", 
+                  snapshot->version);
+  __LEAVE_FUNCTION
+}
+
+void Config::collect() {
+  __ENTER_FUNCTION
+    //缓存的版本大于旧快照的版本，说明已经切换到更新的快照，之后也不会再读到它
+    pap_common_base::util::memory_barrier();
+    std::vector<config_snapshot_t*>::iterator it = retired_snapshot_.begin();
+    while (it != retired_snapshot_.end()) {
+      bool used = false;
+      int32_t i;
+      for (i = 0; i < cache_count_ && !used; ++i) {
+        used = cache_[i]->get_version() <= (*it)->version;
+      }
+      if (used) {
+        ++it;
+        continue;
+      }
+      SAFE_DELETE(*it);
+      it = retired_snapshot_.erase(it);
+    }
   __LEAVE_FUNCTION
 }
 
@@ -616,6 +804,14 @@ void Config::load_config_info_reload() { //this params can reload again
       config_info_ini.read_uint32("Time", "TimeChangeInterval");
     config_info_.time.packet_audit_time = 
       config_info_ini.read_uint32("Time", "PacketAuditTime");
+    config_info_.packet_audit.throttle_count = 
+      config_info_ini.read_uint32("PacketAudit", "ThrottleCount");
+    config_info_.packet_audit.kick_count = 
+      config_info_ini.read_uint32("PacketAudit", "KickCount");
+    config_info_.packet_audit.kick_packet_count = 
+      config_info_ini.read_uint32("PacketAudit", "KickPacketCount");
+    config_info_.packet_audit.dump = 
+      config_info_ini.read_bool("PacketAudit", "Dump");
     config_info_.monster.max_count = 
       config_info_ini.read_uint32("Monster", "MaxCount");
     config_info_.monster.default_respawn_time = 
@@ -929,14 +1125,6 @@ void Config::load_config_info_reload() { //this params can reload again
     }
     //loop read --
 
-    config_info_.fatigue.enable = 
-      config_info_ini.read_bool("Fatigue", "Enable");
-    config_info_.fatigue.little_fatigue_time = 
-      config_info_ini.read_uint32("Fatigue", "LittleFatigueTime");
-    config_info_.fatigue.exceeding_fatigue_time = 
-      config_info_ini.read_uint32("Fatigue", "ExceedingFatigueTime");
-    config_info_.fatigue.reset_fatigue_state_offline_time = 
-      config_info_ini.read_uint32("Fatigue", "ResetFatigueStateOfflineTime");
     config_info_.yuanbao.max_day_can_cost = 
       config_info_ini.read_uint32("YuanBao", "MaxDayCanCost");
     config_info_.yuanbao.enable_exchage_yuanbao_ticket = 
@@ -1004,6 +1192,30 @@ void Config::load_config_info_reload() { //this params can reload again
     //loop read --
     Log::save_log("config", "load %s reload ... ok!", CONFIG_INFO_FILE);
   __LEAVE_FUNCTION
+#elif defined(_PAP_BILLING)
+  __ENTER_FUNCTION
+    //billing只需要登录队列、元宝和消息统计的设置
+    pap_common_file::Ini config_info_ini(CONFIG_INFO_FILE);
+    config_info_.time.packet_audit_time = 
+      config_info_ini.read_uint32("Time", "PacketAuditTime");
+    config_info_.packet_audit.throttle_count = 
+      config_info_ini.read_uint32("PacketAudit", "ThrottleCount");
+    config_info_.packet_audit.kick_count = 
+      config_info_ini.read_uint32("PacketAudit", "KickCount");
+    config_info_.packet_audit.kick_packet_count = 
+      config_info_ini.read_uint32("PacketAudit", "KickPacketCount");
+    config_info_.packet_audit.dump = 
+      config_info_ini.read_bool("PacketAudit", "Dump");
+    config_info_.login_queue.turn_player_count = 
+      config_info_ini.read_uint32("LoginQueue", "TurnPlayerCount");
+    config_info_.login_queue.relogin_limit = 
+      config_info_ini.read_bool("LoginQueue", "ReloginLimit");
+    config_info_.login_queue.relogin_time = 
+      config_info_ini.read_uint32("LoginQueue", "ReloginTime");
+    config_info_.yuanbao.max_day_can_cost = 
+      config_info_ini.read_uint32("YuanBao", "MaxDayCanCost");
+    Log::save_log("config", "load %s reload ... ok!", CONFIG_INFO_FILE);
+  __LEAVE_FUNCTION
 #endif
 }
 
@@ -1225,7 +1437,8 @@ void Config::load_share_memory_info() {
 }
 
 void Config::load_share_memory_info_only() {
-#if defined(_PAP_SHAREMEMORY)
+//挂接共享内存的进程都要读取实现方式，否则和共享内存进程的后端不一致
+#if defined(_PAP_SHAREMEMORY) || defined(_PAP_WORLD) || defined(_PAP_SERVER)
   __ENTER_FUNCTION
     pap_common_file::Ini share_memory_info_ini(SHARE_MEMORY_INFO_FILE);
     share_memory_info_.obj_count = 
@@ -1276,6 +1489,36 @@ void Config::load_share_memory_info_only() {
       share_memory_info_ini.read_uint32("System", "HumanDataSaveInterval");
     share_memory_info_.encrypt_password = 
       share_memory_info_ini.read_bool("System", "EncryptPassword");
+    share_memory_info_ini.read_exist_int32("System", 
+                                           "Backend", 
+                                           share_memory_info_.backend_type);
+    uint8_t huge_page = 0;
+    if (share_memory_info_ini.read_exist_uint8("System", 
+                                               "HugePage", 
+                                               huge_page)) {
+      share_memory_info_.huge_page = 1 == huge_page;
+    }
+    share_memory_info_ini.read_existstring(
+        "System", "MmapFilePath", share_memory_info_.mmap_file_path, 
+        sizeof(share_memory_info_.mmap_file_path) - 1);
+    share_memory_info_ini.read_existstring(
+        "System", "SnapshotPath", share_memory_info_.snapshot_path, 
+        sizeof(share_memory_info_.snapshot_path) - 1);
+    uint8_t journal = 0;
+    if (share_memory_info_ini.read_exist_uint8("System", 
+                                               "JournalSwitch", 
+                                               journal)) {
+      share_memory_info_.journal = 1 == journal;
+    }
+    share_memory_info_ini.read_existstring(
+        "System", "JournalPath", share_memory_info_.journal_path, 
+        sizeof(share_memory_info_.journal_path) - 1);
+    pap_server_common_sys::share_memory::set_backend(
+        share_memory_info_.backend_type,
+        share_memory_info_.huge_page,
+        share_memory_info_.mmap_file_path);
+    pap_server_common_sys::share_memory::set_snapshot_path(
+        share_memory_info_.snapshot_path);
     Log::save_log("config", "load %s only ... ok!", SHARE_MEMORY_INFO_FILE);
   __LEAVE_FUNCTION
 #endif
@@ -24,6 +24,10 @@ void head_t::clean_up() {
     use_status = pap_server_common_sys::share_memory::kUseFree;
     flag = pap_server_common_sys::share_memory::kFlagFree;
     save_time = 0;
+    version = 0;
+    save_version = 0;
+    sequence = 0;
+    lock_contended = 0;
   __LEAVE_FUNCTION
 }
 
@@ -35,7 +39,9 @@ void global_data_t::init() {
 
 void global_data_t::lock(char type) {
   __ENTER_FUNCTION
-    pap_server_common_sys::share_memory::lock(head.flag, type);
+    pap_server_common_sys::share_memory::lock(head.flag, 
+                                              type, 
+                                              &head.lock_contended);
   __LEAVE_FUNCTION
 }
 
@@ -98,12 +104,57 @@ void global_data_t::set_save_time(uint32_t time, char type) {
   __LEAVE_FUNCTION
 }
 
-uint32_t global_data_t::get_data(char type) {
+uint32_t global_data_t::get_version(char type) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_sys::share_memory;
+    USE_PARAM(type);
+    uint32_t version = 0;
+    uint32_t start;
+    do {
+      start = read_begin(head.sequence);
+      version = head.version;
+    } while (read_retry(head.sequence, start));
+    return version;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+bool global_data_t::is_dirty(char type) {
+  __ENTER_FUNCTION
+    bool result = false;
+    lock(type);
+    result = head.version != head.save_version;
+    unlock(type);
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void global_data_t::set_save_version(uint32_t version, char type) {
   __ENTER_FUNCTION
-    uint32_t data;
     lock(type);
-    data = global_data;
+    head.save_version = version;
     unlock(type);
+  __LEAVE_FUNCTION
+}
+
+uint32_t global_data_t::get_lock_contended() {
+  __ENTER_FUNCTION
+    return *static_cast<volatile uint32_t*>(&head.lock_contended);
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+uint32_t global_data_t::get_data(char type) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_sys::share_memory;
+    USE_PARAM(type);
+    uint32_t data;
+    uint32_t start;
+    do { //读多写少，读取不加锁
+      start = read_begin(head.sequence);
+      data = global_data;
+    } while (read_retry(head.sequence, start));
     return data;
   __LEAVE_FUNCTION
     return 0;
@@ -111,8 +162,14 @@ uint32_t global_data_t::get_data(char type) {
 
 void global_data_t::set_data(char type, uint32_t data) {
   __ENTER_FUNCTION
+    using namespace pap_server_common_sys::share_memory;
     lock(type);
-    global_data = data;
+    if (global_data != data) {
+      write_begin(head.sequence);
+      global_data = data;
+      ++head.version;
+      write_end(head.sequence);
+    }
     unlock(type);
   __LEAVE_FUNCTION
 }
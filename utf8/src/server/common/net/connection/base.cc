@@ -50,6 +50,8 @@ Base::Base(bool flag_isserver) {
     isempty_ = true;
     isdisconnect_ = false;
     packetindex_ = 0;
+    rpc_ = NULL;
+    packet_audit_ = NULL;
   __LEAVE_FUNCTION
 }
 
@@ -58,6 +60,8 @@ Base::~Base() {
     SAFE_DELETE(socket_outputstream_);
     SAFE_DELETE(socket_inputstream_);
     SAFE_DELETE(socket_);
+    SAFE_DELETE(rpc_);
+    SAFE_DELETE(packet_audit_);
   __LEAVE_FUNCTION
 }
 
@@ -152,6 +156,7 @@ bool Base::processcommand(bool option) {
       const uint8_t kExecuteCountPreTick = 12; //每帧可以执行的消息数量上限
       uint32_t i;
       for (i = 0; i < kExecuteCountPreTick; ++i) {
+        if (is_packet_throttled()) break;
         if (!socket_inputstream_->peek(&packetheader[0], PACKET_HEADERSIZE)) {
           //数据不能填充消息头
           break;
@@ -181,6 +186,7 @@ bool Base::processcommand(bool option) {
             AssertEx(false, temp);
             return false;
           }
+          if (!audit_packet(packetid, packetsize)) return false;
           //create packet
           packet = g_packetfactory_manager->createpacket(packetid);
           if (NULL == packet) return false;
@@ -192,6 +198,11 @@ bool Base::processcommand(bool option) {
             g_packetfactory_manager->removepacket(packet);
             return result;
           }
+          if (rpc_dispatch(packet)) { //请求的回应已经交给回调
+            resetkick();
+            g_packetfactory_manager->removepacket(packet);
+            continue;
+          }
           bool needremove = true;
           bool exception = false;
           uint32_t executestatus = 0;
@@ -288,8 +299,11 @@ bool Base::sendpacket(pap_common_net::packet::Base* packet) {
 }
 
 bool Base::heartbeat(uint32_t time, uint32_t flag) {
-  USE_PARAM(time);
   USE_PARAM(flag);
+  if (rpc_ && time != 0) rpc_->expire(this, time);
+  if (packet_audit_ && time != 0) {
+    packet_audit_->tick(time, getid(), socket_->host_);
+  }
   return true;
 }
 
@@ -321,6 +335,14 @@ pap_common_net::socket::Base* Base::getsocket() {
   return socket_;
 }
 
+pap_common_net::socket::InputStream* Base::get_socket_inputstream() {
+  return socket_inputstream_;
+}
+
+pap_common_net::socket::OutputStream* Base::get_socket_outputstream() {
+  return socket_outputstream_;
+}
+
 void Base::disconnect() {
   __ENTER_FUNCTION
     socket_->close();
@@ -345,6 +367,8 @@ void Base::cleanup() {
     set_managerid(ID_INVALID);
     set_userid(ID_INVALID);
     packetindex_ = 0;
+    if (rpc_) rpc_->cancel(this);
+    if (packet_audit_) packet_audit_->cleanup();
     setdisconnect(false);
   __LEAVE_FUNCTION
 }
@@ -369,6 +393,66 @@ void Base::resetkick() {
   //do nothing
 }
 
+uint32_t Base::rpc_call(pap_common_net::packet::Base* packet,
+                        rpc_callback_function callback,
+                        void* data,
+                        uint32_t timeout) {
+  __ENTER_FUNCTION
+    Assert(packet);
+    if (isdisconnect()) return 0;
+    if (NULL == rpc_) {
+      rpc_ = new Rpc();
+      Assert(rpc_);
+      if (!rpc_->init()) return 0;
+    }
+    uint32_t now = g_time_manager->get_current_time();
+    uint32_t requestid = rpc_->add(callback, data, now + timeout);
+    if (0 == requestid) return 0;
+    packet->set_requestid(requestid);
+    //消息不支持请求ID，回应无法对应
+    if (packet->get_requestid() != requestid || !sendpacket(packet)) {
+      rpc_->remove(requestid);
+      return 0;
+    }
+    return requestid;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+uint32_t Base::get_rpc_count() const {
+  return NULL == rpc_ ? 0 : rpc_->get_count();
+}
+
+bool Base::audit_packet(uint16_t packetid, uint32_t size) {
+  __ENTER_FUNCTION
+    if (NULL == packet_audit_) {
+      if (!PacketAudit::is_enable()) return true;
+      packet_audit_ = new PacketAudit();
+      Assert(packet_audit_);
+    }
+    if (kPacketAuditKick == packet_audit_->receive(packetid, size)) {
+      packet_audit_->dump(getid(), socket_->host_, 0);
+      return false;
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return true;
+}
+
+bool Base::is_packet_throttled() const {
+  return packet_audit_ != NULL && packet_audit_->is_throttled();
+}
+
+bool Base::rpc_dispatch(pap_common_net::packet::Base* packet) {
+  __ENTER_FUNCTION
+    if (NULL == rpc_ || !(packet->get_requestid() & kRpcResponseFlag)) {
+      return false;
+    }
+    return rpc_->complete(this, packet);
+  __LEAVE_FUNCTION
+    return false;
+}
+
 } //namespace connection
 
 } //namespace pap_server_common_net
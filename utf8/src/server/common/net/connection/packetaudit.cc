@@ -0,0 +1,160 @@
+#include "server/common/net/connection/packetaudit.h"
+#include "server/common/net/connection/base.h"
+#include "server/common/base/log.h"
+
+namespace pap_server_common_net {
+
+namespace connection {
+
+PacketAudit::setting_t PacketAudit::setting_ = {0, {0, 0, 0, false}};
+
+PacketAudit::PacketAudit() {
+  __ENTER_FUNCTION
+    start_time_ = 0;
+    cleanup();
+  __LEAVE_FUNCTION
+}
+
+PacketAudit::~PacketAudit() {
+  //do nothing
+}
+
+packet_audit_result_enum PacketAudit::receive(uint16_t packetid,
+                                              uint32_t size) {
+  __ENTER_FUNCTION
+    ++count_;
+    size_ += size;
+    slot_t* slot = find(packetid);
+    uint32_t packet_count = 0;
+    if (slot) {
+      ++slot->count;
+      slot->size += size;
+      packet_count = slot->count;
+    }
+    else {
+      packet_count = ++other_count_;
+    }
+    const pap_server_common_base::packet_audit_setting_t &setting =
+      setting_.packet_audit;
+    if ((setting.kick_count != 0 && count_ > setting.kick_count) ||
+        (setting.kick_packet_count != 0 &&
+         packet_count > setting.kick_packet_count)) {
+      kicked_ = true;
+      return kPacketAuditKick;
+    }
+    if (setting.throttle_count != 0 && count_ >= setting.throttle_count) {
+      throttled_ = true;
+    }
+    return kPacketAuditPass;
+  __LEAVE_FUNCTION
+    return kPacketAuditPass;
+}
+
+bool PacketAudit::is_throttled() const {
+  return throttled_;
+}
+
+void PacketAudit::tick(uint32_t now, int16_t connectionid, const char* host) {
+  __ENTER_FUNCTION
+    if (0 == setting_.audit_time) {
+      if (count_ != 0) cleanup();
+      return;
+    }
+    if (0 == start_time_) start_time_ = now;
+    if (now - start_time_ < setting_.audit_time) return;
+    if (throttled_ || setting_.packet_audit.dump) {
+      dump(connectionid, host, now - start_time_);
+    }
+    cleanup();
+    start_time_ = now;
+  __LEAVE_FUNCTION
+}
+
+void PacketAudit::cleanup() {
+  __ENTER_FUNCTION
+    memset(slot_, 0, sizeof(slot_));
+    other_count_ = 0;
+    count_ = 0;
+    size_ = 0;
+    throttled_ = false;
+    kicked_ = false;
+  __LEAVE_FUNCTION
+}
+
+void PacketAudit::set_setting(
+    uint32_t audit_time,
+    const pap_server_common_base::packet_audit_setting_t &packet_audit) {
+  setting_.audit_time = audit_time;
+  setting_.packet_audit = packet_audit;
+}
+
+bool PacketAudit::is_enable() {
+  return setting_.audit_time != 0;
+}
+
+PacketAudit::slot_t* PacketAudit::find(uint16_t packetid) {
+  __ENTER_FUNCTION
+    if (0 == packetid) return NULL;
+    //线性探测，满了以后归到other_count_
+    uint32_t position = (packetid * 0x9E37U >> 4) & (kPacketAuditSlotMax - 1);
+    uint32_t i;
+    for (i = 0; i < kPacketAuditSlotMax; ++i) {
+      slot_t* slot = &slot_[(position + i) & (kPacketAuditSlotMax - 1)];
+      if (slot->packetid == packetid) return slot;
+      if (0 == slot->packetid) {
+        slot->packetid = packetid;
+        return slot;
+      }
+    }
+    return NULL;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void PacketAudit::dump(int16_t connectionid, const char* host, uint32_t time) {
+  __ENTER_FUNCTION
+    if (0 == count_) return;
+    //只列出数量最多的几种消息
+    const slot_t* top[kPacketAuditDumpMax] = {NULL};
+    uint32_t i;
+    for (i = 0; i < kPacketAuditSlotMax; ++i) {
+      const slot_t* slot = &slot_[i];
+      if (0 == slot->count) continue;
+      uint32_t j = kPacketAuditDumpMax;
+      while (j > 0 && (NULL == top[j - 1] ||
+             top[j - 1]->count < slot->count)) {
+        if (j < kPacketAuditDumpMax) top[j] = top[j - 1];
+        --j;
+      }
+      if (j < kPacketAuditDumpMax) top[j] = slot;
+    }
+    char detail[512] = {0};
+    int32_t length = 0;
+    for (i = 0; i < kPacketAuditDumpMax && top[i]; ++i) {
+      length += snprintf(detail + length,
+                         sizeof(detail) - 1 - length,
+                         " %d:%u/%u",
+                         top[i]->packetid,
+                         top[i]->count,
+                         top[i]->size);
+      if (length >= static_cast<int32_t>(sizeof(detail) - 1)) break;
+    }
+    g_log->fast_save_log(static_cast<enum_log_id>(g_kModelSaveLogId),
+                         "[net][audit] connection: %d(%s), time: %u,"
+                         " count: %u, size: %u, other: %u, %s%s"
+                         " packets(id:count/size):%s",
+                         connectionid,
+                         host ? host : "",
+                         time,
+                         count_,
+                         size_,
+                         other_count_,
+                         throttled_ ? "throttled " : "",
+                         kicked_ ? "kicked " : "",
+                         detail);
+  __LEAVE_FUNCTION
+}
+
+} //namespace connection
+
+} //namespace pap_server_common_net
@@ -0,0 +1,183 @@
+#include "server/common/net/connection/rpc.h"
+#include <algorithm>
+
+namespace pap_server_common_net {
+
+namespace connection {
+
+//超时时间会回绕，按差值比较
+struct TimerGreater {
+  bool operator()(const Rpc::timer_t &a, const Rpc::timer_t &b) const {
+    return static_cast<int32_t>(a.deadline - b.deadline) > 0;
+  }
+};
+
+Rpc::Rpc() {
+  __ENTER_FUNCTION
+    request_ = NULL;
+    free_ = NULL;
+    free_number_ = 0;
+    mask_ = 0;
+    shift_ = 0;
+    serial_ = 0;
+  __LEAVE_FUNCTION
+}
+
+Rpc::~Rpc() {
+  __ENTER_FUNCTION
+    SAFE_DELETE_ARRAY(request_);
+    SAFE_DELETE_ARRAY(free_);
+  __LEAVE_FUNCTION
+}
+
+bool Rpc::init(uint32_t requestmax) {
+  __ENTER_FUNCTION
+    if (0 == requestmax) return false;
+    uint32_t count = 1;
+    shift_ = 0;
+    while (count < requestmax) {
+      count <<= 1;
+      ++shift_;
+    }
+    SAFE_DELETE_ARRAY(request_);
+    SAFE_DELETE_ARRAY(free_);
+    request_ = new request_t[count];
+    Assert(request_);
+    free_ = new uint32_t[count];
+    Assert(free_);
+    memset(request_, 0, sizeof(request_t) * count);
+    uint32_t i;
+    for (i = 0; i < count; ++i) free_[i] = count - 1 - i;
+    free_number_ = count;
+    mask_ = count - 1;
+    serial_ = 0;
+    timer_.clear();
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+uint32_t Rpc::add(rpc_callback_function callback,
+                  void* data,
+                  uint32_t deadline) {
+  __ENTER_FUNCTION
+    if (NULL == request_ || 0 == free_number_) return 0;
+    uint32_t position = free_[--free_number_];
+    //序号部分不为0，请求ID就不会是0，最高位留给回应标记
+    ++serial_;
+    if ((serial_ << shift_) >= kRpcResponseFlag) serial_ = 1;
+    request_t* request = &request_[position];
+    request->requestid = (serial_ << shift_) | position;
+    request->callback = callback;
+    request->data = data;
+    request->deadline = deadline;
+    if (timer_.size() >= (mask_ + 1) * 4) compact();
+    timer_t timer;
+    timer.deadline = deadline;
+    timer.requestid = request->requestid;
+    timer_.push_back(timer);
+    std::push_heap(timer_.begin(), timer_.end(), TimerGreater());
+    return request->requestid;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+void Rpc::remove(uint32_t requestid) {
+  __ENTER_FUNCTION
+    request_t* request = find(requestid);
+    if (request) release(request);
+  __LEAVE_FUNCTION
+}
+
+bool Rpc::complete(Base* connection, pap_common_net::packet::Base* packet) {
+  __ENTER_FUNCTION
+    Assert(packet);
+    uint32_t requestid = packet->get_requestid() & ~kRpcResponseFlag;
+    request_t* request = find(requestid);
+    if (NULL == request) return false;
+    //先释放再回调，回调里可以发起新的请求
+    rpc_callback_function callback = request->callback;
+    void* data = request->data;
+    release(request);
+    if (callback) (*callback)(connection, requestid, packet, data);
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+uint32_t Rpc::expire(Base* connection, uint32_t now) {
+  __ENTER_FUNCTION
+    uint32_t count = 0;
+    while (!timer_.empty()) {
+      timer_t timer = timer_.front();
+      if (static_cast<int32_t>(now - timer.deadline) < 0) break;
+      std::pop_heap(timer_.begin(), timer_.end(), TimerGreater());
+      timer_.pop_back();
+      request_t* request = find(timer.requestid);
+      if (NULL == request) continue; //已经完成
+      rpc_callback_function callback = request->callback;
+      void* data = request->data;
+      release(request);
+      ++count;
+      if (callback) (*callback)(connection, timer.requestid, NULL, data);
+    }
+    return count;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+void Rpc::cancel(Base* connection) {
+  __ENTER_FUNCTION
+    if (NULL == request_) return;
+    std::vector<timer_t> timer;
+    timer.swap(timer_);
+    uint32_t i;
+    for (i = 0; i < timer.size(); ++i) {
+      request_t* request = find(timer[i].requestid);
+      if (NULL == request) continue;
+      rpc_callback_function callback = request->callback;
+      void* data = request->data;
+      release(request);
+      if (callback) (*callback)(connection, timer[i].requestid, NULL, data);
+    }
+  __LEAVE_FUNCTION
+}
+
+uint32_t Rpc::get_count() const {
+  return NULL == request_ ? 0 : mask_ + 1 - free_number_;
+}
+
+void Rpc::compact() {
+  __ENTER_FUNCTION
+    std::vector<timer_t> timer;
+    timer.reserve(mask_ + 1 - free_number_);
+    uint32_t i;
+    for (i = 0; i < timer_.size(); ++i) {
+      if (find(timer_[i].requestid)) timer.push_back(timer_[i]);
+    }
+    std::make_heap(timer.begin(), timer.end(), TimerGreater());
+    timer_.swap(timer);
+  __LEAVE_FUNCTION
+}
+
+Rpc::request_t* Rpc::find(uint32_t requestid) {
+  __ENTER_FUNCTION
+    if (NULL == request_ || 0 == requestid) return NULL;
+    request_t* request = &request_[requestid & mask_];
+    return request->requestid == requestid ? request : NULL;
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void Rpc::release(request_t* request) {
+  __ENTER_FUNCTION
+    request->requestid = 0;
+    request->callback = NULL;
+    request->data = NULL;
+    free_[free_number_++] = static_cast<uint32_t>(request - request_);
+  __LEAVE_FUNCTION
+}
+
+} //namespace connection
+
+} //namespace pap_server_common_net
@@ -6,28 +6,35 @@ namespace packets {
 
 namespace billing_tologin {
 
-ResultAuth::ResultAuth() {
+ResultAuth::ResultAuth(bool withrequest) {
   __ENTER_FUNCTION
     memset(account_, 0, sizeof(account_));
     memset(servername_, 0, sizeof(servername_));
+    requestid_ = 0;
+    withrequest_ = withrequest;
   __LEAVE_FUNCTION
 }
 
 bool ResultAuth::read(pap_common_net::socket::InputStream& inputstream) {
   __ENTER_FUNCTION
+    //旧的格式中这些标记长度为0，已经部署的登录服务器也是这样读的
+    uint32_t flaglength = withrequest_ ? sizeof(char) : 0;
     inputstream.read(account_, sizeof(account_) - 1);
     inputstream.read((char*)(&result_), sizeof(result_));
     inputstream.read((char*)(&playerid_), sizeof(playerid_));
     inputstream.read((char*)(&playerguid_), sizeof(playerguid_));
     inputstream.read(servername_, sizeof(servername_) - 1);
-    inputstream.read((char*)&isfatigue_, sizeof(isfatigue_) - 1);
+    inputstream.read((char*)&isfatigue_, flaglength);
     inputstream.read((char*)(&total_onlinetime_), sizeof(total_onlinetime_));
-    inputstream.read((char*)&isphone_bind_, sizeof(isphone_bind_) - 1);
-    inputstream.read((char*)&isip_bind_, sizeof(isip_bind_) - 1);
-    inputstream.read((char*)&ismibao_bind_, sizeof(ismibao_bind_) - 1);
-    inputstream.read((char*)&ismac_bind_, sizeof(ismac_bind_) - 1);
-    inputstream.read((char*)&is_realname_bind_, sizeof(is_realname_bind_) - 1);
-    inputstream.read((char*)&is_inputname_bind_, sizeof(is_inputname_bind_) - 1);
+    inputstream.read((char*)&isphone_bind_, flaglength);
+    inputstream.read((char*)&isip_bind_, flaglength);
+    inputstream.read((char*)&ismibao_bind_, flaglength);
+    inputstream.read((char*)&ismac_bind_, flaglength);
+    inputstream.read((char*)&is_realname_bind_, flaglength);
+    inputstream.read((char*)&is_inputname_bind_, flaglength);
+    if (withrequest_) {
+      inputstream.read((char*)(&requestid_), sizeof(requestid_));
+    }
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -35,19 +42,24 @@ bool ResultAuth::read(pap_common_net::socket::InputStream& inputstream) {
 
 bool ResultAuth::write(pap_common_net::socket::OutputStream& outputstream) const {
   __ENTER_FUNCTION
+    //旧的格式中这些标记长度为0，已经部署的登录服务器也是这样读的
+    uint32_t flaglength = withrequest_ ? sizeof(char) : 0;
     outputstream.write(account_, sizeof(account_) - 1);
     outputstream.write((char*)(&result_), sizeof(result_));
     outputstream.write((char*)(&playerid_), sizeof(playerid_));
     outputstream.write((char*)(&playerguid_), sizeof(playerguid_));
     outputstream.write(servername_, sizeof(servername_) - 1);
-    outputstream.write((char*)&isfatigue_, sizeof(isfatigue_) - 1);
+    outputstream.write((char*)&isfatigue_, flaglength);
     outputstream.write((char*)(&total_onlinetime_), sizeof(total_onlinetime_));
-    outputstream.write((char*)&isphone_bind_, sizeof(isphone_bind_) - 1);
-    outputstream.write((char*)&isip_bind_, sizeof(isip_bind_) - 1);
-    outputstream.write((char*)&ismibao_bind_, sizeof(ismibao_bind_) - 1);
-    outputstream.write((char*)&ismac_bind_, sizeof(ismac_bind_) - 1);
-    outputstream.write((char*)&is_realname_bind_, sizeof(is_realname_bind_) - 1);
-    outputstream.write((char*)&is_inputname_bind_, sizeof(is_inputname_bind_) - 1);
+    outputstream.write((char*)&isphone_bind_, flaglength);
+    outputstream.write((char*)&isip_bind_, flaglength);
+    outputstream.write((char*)&ismibao_bind_, flaglength);
+    outputstream.write((char*)&ismac_bind_, flaglength);
+    outputstream.write((char*)&is_realname_bind_, flaglength);
+    outputstream.write((char*)&is_inputname_bind_, flaglength);
+    if (withrequest_) {
+      outputstream.write((char*)(&requestid_), sizeof(requestid_));
+    }
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -64,7 +76,9 @@ uint32_t ResultAuth::execute(connection::Base* connection) {
 
 uint16_t ResultAuth::getid() const {
   using namespace pap_server_common_game::define;
-  return id::packet::billing_tologin::kResultAuth;
+  return withrequest_ ? 
+         id::packet::billing_tologin::kResultAuthRpc : 
+         id::packet::billing_tologin::kResultAuth;
 }
 
 uint32_t ResultAuth::getsize() const {
@@ -81,9 +95,19 @@ uint32_t ResultAuth::getsize() const {
                     sizeof(ismac_bind_) +
                     sizeof(is_realname_bind_) +
                     sizeof(is_inputname_bind_);
+  if (withrequest_) result += sizeof(requestid_);
   return result;
 }
 
+uint32_t ResultAuth::get_requestid() const {
+  return requestid_;
+}
+
+void ResultAuth::set_requestid(uint32_t requestid) {
+  requestid_ = requestid;
+  withrequest_ = requestid != 0;
+}
+
 void ResultAuth::get_account(char* buffer, uint16_t length) {
   __ENTER_FUNCTION
     snprintf(buffer, length, account_);
@@ -202,6 +226,24 @@ uint32_t ResultAuthFactory::get_packet_maxsize() const {
   return result;
 }
 
+pap_common_net::packet::Base* ResultAuthRpcFactory::createpacket() {
+  __ENTER_FUNCTION
+    return new ResultAuth(true);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+uint16_t ResultAuthRpcFactory::get_packetid() const {
+  using namespace pap_server_common_game::define;
+  return id::packet::billing_tologin::kResultAuthRpc;
+}
+
+uint32_t ResultAuthRpcFactory::get_packet_maxsize() const {
+  uint32_t result = ResultAuthFactory().get_packet_maxsize() + 
+                    sizeof(uint32_t);
+  return result;
+}
+
 } //namespace billing_tologin
 
 } //namespace packets
@@ -8,7 +8,7 @@ namespace packets {
 namespace login_tobilling {
 
 
-AskAuth::AskAuth() {
+AskAuth::AskAuth(bool withrequest) {
   __ENTER_FUNCTION
     using namespace pap_common_game::define::size;
     memset(account_, '\0', sizeof(account_));
@@ -20,6 +20,9 @@ AskAuth::AskAuth() {
       memset(all_mibao_value[i], '\0', sizeof(all_mibao_value[i]));
     }
     memset(macaddress_, '\0', sizeof(macaddress_));
+    playerid_ = 0;
+    requestid_ = 0;
+    withrequest_ = withrequest;
   __LEAVE_FUNCTION
 }
 
@@ -38,6 +41,10 @@ bool AskAuth::read(pap_common_net::socket::InputStream& inputstream) {
       inputstream.read(all_mibao_value[i], sizeof(all_mibao_value[i]) - 1);
     }
     inputstream.read(macaddress_, sizeof(macaddress_) - 1);
+    if (withrequest_) {
+      inputstream.read(reinterpret_cast<char*>(&requestid_),
+                       sizeof(requestid_));
+    }
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -58,6 +65,9 @@ bool AskAuth::write(pap_common_net::socket::OutputStream& outputstream) const {
       outputstream.write(all_mibao_value[i], sizeof(all_mibao_value[i]) - 1);
     }
     outputstream.write(macaddress_, sizeof(macaddress_) - 1);
+    if (withrequest_) {
+      outputstream.write((char*)&requestid_, sizeof(requestid_));
+    }
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -74,7 +84,9 @@ uint32_t AskAuth::execute(connection::Base* connection) {
 
 uint16_t AskAuth::getid() const {
   using namespace pap_server_common_game::define;
-  return id::packet::login_tobilling::kAskAuth;
+  return withrequest_ ? 
+         id::packet::login_tobilling::kAskAuthRpc : 
+         id::packet::login_tobilling::kAskAuth;
 }
 
 uint32_t AskAuth::getsize() const {
@@ -85,9 +97,20 @@ uint32_t AskAuth::getsize() const {
                     sizeof(all_mibao_key) - mibao::kUnitNumber * 1 +
                     sizeof(all_mibao_value) - mibao::kUnitNumber * 1 +
                     sizeof(macaddress_) - 1;
+  //旧的登录服务器不计算playerid，保持一致
+  if (withrequest_) result += sizeof(playerid_) + sizeof(requestid_);
   return result;
 }
 
+uint32_t AskAuth::get_requestid() const {
+  return requestid_;
+}
+
+void AskAuth::set_requestid(uint32_t requestid) {
+  requestid_ = requestid;
+  withrequest_ = requestid != 0;
+}
+
 void AskAuth::getaccount(char* buffer, uint8_t length) const {
   __ENTER_FUNCTION
     snprintf(buffer, length, "%s", account_);
@@ -227,6 +250,25 @@ uint32_t AskAuthFactory::get_packet_maxsize() const {
   return result;
 }
 
+pap_common_net::packet::Base* AskAuthRpcFactory::createpacket() {
+  __ENTER_FUNCTION
+    return new AskAuth(true);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+uint16_t AskAuthRpcFactory::get_packetid() const {
+  using namespace pap_server_common_game::define;
+  return id::packet::login_tobilling::kAskAuthRpc;
+}
+
+uint32_t AskAuthRpcFactory::get_packet_maxsize() const {
+  uint32_t result = AskAuthFactory().get_packet_maxsize() +
+                    sizeof(uint16_t) +
+                    sizeof(uint32_t);
+  return result;
+}
+
 } //namespace login_tobilling
 
 } //namespace packets
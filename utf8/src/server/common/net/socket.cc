@@ -47,6 +47,17 @@ Socket::Socket(uint16_t port, uint32_t backlog) {
   __LEAVE_FUNCTION
 }
 
+Socket::Socket() {
+  __ENTER_FUNCTION
+    socket_ = new pap_common_net::socket::Base();
+    if (NULL == socket_) {
+      ERRORPRINTF("pap_server_common_net::Socket::Socket"
+                  " new pap_common_net::socket::Base() failed");
+      throw 1;
+    }
+  __LEAVE_FUNCTION
+}
+
 Socket::~Socket() {
   __ENTER_FUNCTION
     if (socket_ != NULL) {
@@ -56,6 +67,16 @@ Socket::~Socket() {
   __LEAVE_FUNCTION
 }
 
+bool Socket::attach(int32_t socketid) {
+  __ENTER_FUNCTION
+    if (NULL == socket_ || SOCKET_INVALID == socketid) return false;
+    socket_->close();
+    socket_->socketid_ = socketid;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
 void Socket::close() {
   if (socket_ != NULL) socket_->close();
 }
@@ -6,8 +6,14 @@
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #elif defined(__WINDOWS__)
 #include <winbase.h>
+#include <intrin.h>
 #endif
 
 namespace pap_server_common_sys {
@@ -16,6 +22,13 @@ namespace share_memory {
 
 uint32_t lock_times = 0;
 bool lock_time_enable = false;
+int32_t backend_type = kBackendSystemV;
+bool huge_page_enable = false;
+char mmap_file_path[FILENAME_MAX] = "/dev/shm";
+char snapshot_path[FILENAME_MAX] = ".";
+#if defined(__LINUX__)
+const uint32_t kHugePageSize = 2 * 1024 * 1024;
+#endif
 
 //-- struct start
 data_header_t::data_header_t() {
@@ -23,6 +36,8 @@ data_header_t::data_header_t() {
     key = 0;
     size = 0;
     version = 0;
+    checksum = 0;
+    snapshot_version = 0;
   __LEAVE_FUNCTION
 }
 
@@ -134,6 +149,116 @@ void close(HANDLE handle) {
   __LEAVE_FUNCTION
 }
 
+#if defined(__LINUX__)
+static void mmap_filename(uint64_t key, char* filename, uint32_t length) {
+  memset(filename, '\0', length);
+  snprintf(filename, 
+           length - 1, 
+           "%s/pap_%"PRIu64".shm", 
+           mmap_file_path, 
+           key);
+}
+
+static uint32_t mmap_length(uint32_t size) { //大页时文件必须按页对齐
+  if (!huge_page_enable) return size;
+  return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+int32_t mmap_create(uint64_t key, uint32_t size) {
+  __ENTER_FUNCTION
+    char filename[FILENAME_MAX + 32]; //目录加上文件名
+    memset(filename, '\0', sizeof(filename));
+    mmap_filename(key, filename, sizeof(filename));
+    int32_t handle = ::open(filename, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (handle != HANDLE_INVALID && 
+        ftruncate(handle, mmap_length(size)) != 0) {
+      ::close(handle);
+      unlink(filename);
+      handle = HANDLE_INVALID;
+    }
+    pap_server_common_base::Log::save_log(
+        "sharememory",
+        "[sharememory][api](mmap_create) handle = %d, file = %s ,error: %d",
+        handle, 
+        filename, 
+        errno);
+    return handle;
+  __LEAVE_FUNCTION
+    return HANDLE_INVALID;
+}
+
+int32_t mmap_open(uint64_t key, uint32_t size) {
+  __ENTER_FUNCTION
+    char filename[FILENAME_MAX + 32]; //目录加上文件名
+    memset(filename, '\0', sizeof(filename));
+    mmap_filename(key, filename, sizeof(filename));
+    int32_t handle = ::open(filename, O_RDWR);
+    struct stat file_stat;
+    if (handle != HANDLE_INVALID && 
+        (fstat(handle, &file_stat) != 0 || 
+         file_stat.st_size < static_cast<off_t>(size))) {
+      ::close(handle);
+      handle = HANDLE_INVALID;
+    }
+    pap_server_common_base::Log::save_log(
+        "sharememory",
+        "[sharememory][api](mmap_open) handle = %d, file = %s ,error: %d",
+        handle, 
+        filename, 
+        errno);
+    return handle;
+  __LEAVE_FUNCTION
+    return HANDLE_INVALID;
+}
+
+void mmap_close(int32_t handle, uint64_t key) {
+  __ENTER_FUNCTION
+    char filename[FILENAME_MAX + 32]; //目录加上文件名
+    memset(filename, '\0', sizeof(filename));
+    mmap_filename(key, filename, sizeof(filename));
+    ::close(handle);
+    unlink(filename);
+  __LEAVE_FUNCTION
+}
+
+char* mmap_map(int32_t handle, uint32_t size) {
+  __ENTER_FUNCTION
+    void* result = MAP_FAILED;
+    uint32_t length = mmap_length(size);
+    if (huge_page_enable) { //文件在hugetlbfs上时才会成功
+      result = mmap(NULL, 
+                    length, 
+                    PROT_READ | PROT_WRITE, 
+                    MAP_SHARED | MAP_HUGETLB, 
+                    handle, 
+                    0);
+    }
+    if (MAP_FAILED == result) {
+      result = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+#if defined(MADV_HUGEPAGE)
+      if (result != MAP_FAILED && huge_page_enable) 
+        madvise(result, length, MADV_HUGEPAGE); //透明大页
+#endif
+    }
+    return MAP_FAILED == result ? NULL : static_cast<char*>(result);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
+void mmap_unmap(char* pointer, uint32_t size) {
+  __ENTER_FUNCTION
+    munmap(pointer, mmap_length(size));
+  __LEAVE_FUNCTION
+}
+
+bool mmap_sync(char* pointer, uint32_t size) {
+  __ENTER_FUNCTION
+    return 0 == msync(pointer, size, MS_SYNC);
+  __LEAVE_FUNCTION
+    return false;
+}
+#endif
+
 } //namespace api
 
 
@@ -144,6 +269,8 @@ Base::Base() {
     handle_ = 0;
     size_ = 0;
     header_ = 0;
+    key_ = 0;
+    backend_ = backend_type;
   __LEAVE_FUNCTION
 }
 
@@ -154,7 +281,16 @@ Base::~Base() {
 bool Base::create(uint64_t key, uint32_t size) {
   __ENTER_FUNCTION
     if (kCmdModelClearAll == cmd_model_) return false;
+#if defined(__LINUX__)
+    if (kBackendMmapFile == backend_) {
+      handle_ = api::mmap_create(key, size);
+    }
+    else {
+      handle_ = api::create(key, size);
+    }
+#else
     handle_ = api::create(key, size);
+#endif
     if (HANDLE_INVALID == handle_) {
       pap_server_common_base::Log::save_log(
           "sharememory", 
@@ -164,7 +300,8 @@ bool Base::create(uint64_t key, uint32_t size) {
           key);
       return false;
     }
-    header_ = api::map(handle_);
+    key_ = key;
+    header_ = map(size);
     if (header_) {
       data_pointer_ = header_ + sizeof(data_header_t);
       (reinterpret_cast<data_header_t*>(header_))->key = key;
@@ -193,6 +330,20 @@ bool Base::create(uint64_t key, uint32_t size) {
 
 void Base::destory() {
   __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (kBackendMmapFile == backend_) {
+      if (header_) {
+        api::mmap_unmap(header_, size_);
+        header_ = NULL;
+      }
+      if (handle_ != HANDLE_INVALID && handle_ != 0) {
+        api::mmap_close(handle_, key_);
+        handle_ = 0;
+      }
+      size_ = 0;
+      return;
+    }
+#endif
     if (header_) {
       api::unmap(header_);
       header_ = NULL;
@@ -205,9 +356,31 @@ void Base::destory() {
   __LEAVE_FUNCTION
 }
 
+char* Base::map(uint32_t size) {
+  __ENTER_FUNCTION
+#if defined(__LINUX__)
+    if (kBackendMmapFile == backend_) return api::mmap_map(handle_, size);
+#endif
+    USE_PARAM(size);
+    return api::map(handle_);
+  __LEAVE_FUNCTION
+    return NULL;
+}
+
 bool Base::attach(uint64_t key, uint32_t size) {
   __ENTER_FUNCTION
+    key_ = key;
+    size_ = size; //destory需要
+#if defined(__LINUX__)
+    if (kBackendMmapFile == backend_) {
+      handle_ = api::mmap_open(key, size);
+    }
+    else {
+      handle_ = api::open(key, size);
+    }
+#else
     handle_ = api::open(key, size);
+#endif
     if (kCmdModelClearAll == cmd_model_) {
       destory();
       pap_server_common_base::Log::save_log(
@@ -223,12 +396,20 @@ bool Base::attach(uint64_t key, uint32_t size) {
           key); 
       return false;
     }
-    header_ = api::map(handle_);
+    header_ = map(size);
     if (header_) {
       data_pointer_ = header_ + sizeof(data_header_t);
       Assert((reinterpret_cast<data_header_t*>(header_))->key == key);
       Assert((reinterpret_cast<data_header_t*>(header_))->size == size);
       size_ = size;
+      if (kCmdModelLoadDump == cmd_model_ && kBackendMmapFile == backend_) {
+        pap_server_common_base::Log::save_log(
+            "sharememory", 
+            "[sharememory][base](attach) restore from file, key = %"PRIu64
+            ", snapshot version = %u", 
+            key, 
+            (reinterpret_cast<data_header_t*>(header_))->snapshot_version);
+      }
       pap_server_common_base::Log::save_log(
           "sharememory", 
           "[sharememory][base](attach) success, key = %"PRIu64"", 
@@ -271,13 +452,39 @@ uint32_t Base::get_size() {
     return 0;
 }
 
-bool Base::dump(const char* filename) {
+bool Base::dump(const char* filename, const char* data) {
   __ENTER_FUNCTION
     Assert(filename);
-    FILE* fp = fopen(filename, "wb");
+    if (!header_) return false;
+    if (!data) data = data_pointer_;
+    //先写临时文件再改名，写到一半崩溃也不会破坏上一次的转储
+    char tempname[FILENAME_MAX + 64];
+    memset(tempname, '\0', sizeof(tempname));
+    snprintf(tempname, sizeof(tempname) - 1, "%s.tmp", filename);
+    uint32_t data_size = size_ - sizeof(data_header_t);
+    //校验和按实际写入的数据计算
+    data_header_t header = *(reinterpret_cast<data_header_t*>(header_));
+    header.checksum = checksum(data, data_size);
+    header.snapshot_version += 1;
+    FILE* fp = fopen(tempname, "wb");
     if (!fp) return false;
-    fwrite(header_, 1, size_, fp);
+    bool result = 1 == fwrite(&header, sizeof(header), 1, fp);
+    result = result && data_size == fwrite(data, 1, data_size, fp);
+    result = 0 == fflush(fp) && result;
+#if defined(__LINUX__)
+    result = 0 == fsync(fileno(fp)) && result;
+#endif
     fclose(fp);
+    if (!result) {
+      remove(tempname);
+      return false;
+    }
+#if defined(__WINDOWS__)
+    remove(filename);
+#endif
+    if (0 != rename(tempname, filename)) return false;
+    (reinterpret_cast<data_header_t*>(header_))->snapshot_version = 
+      header.snapshot_version;
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -286,18 +493,85 @@ bool Base::dump(const char* filename) {
 bool Base::merge_from_file(const char* filename) {
   __ENTER_FUNCTION
     Assert(filename);
+    if (!header_) return false;
     FILE* fp = fopen(filename, "rb");
     if (!fp) return false;
     fseek(fp, 0L, SEEK_END);
     int32_t filelength = ftell(fp);
     fseek(fp, 0L, SEEK_SET);
-    fread(header_, filelength, 1, fp);
+    data_header_t header;
+    if (filelength != static_cast<int32_t>(size_) ||
+        1 != fread(&header, sizeof(header), 1, fp) ||
+        header.key != key_ ||
+        header.size != size_) {
+      fclose(fp);
+      pap_server_common_base::Log::save_log(
+          "sharememory", 
+          "[sharememory][base](merge_from_file) header mismatch, file: %s", 
+          filename);
+      return false;
+    }
+    //先读到临时缓存，校验通过后才覆盖共享内存
+    uint32_t data_size = size_ - sizeof(data_header_t);
+    char* data = new char[data_size];
+    Assert(data);
+    bool result = 1 == fread(data, data_size, 1, fp);
     fclose(fp);
+    if (!result || header.checksum != checksum(data, data_size)) {
+      SAFE_DELETE_ARRAY(data);
+      pap_server_common_base::Log::save_log(
+          "sharememory", 
+          "[sharememory][base](merge_from_file) checksum failed, file: %s", 
+          filename);
+      return false;
+    }
+    memcpy(data_pointer_, data, data_size);
+    SAFE_DELETE_ARRAY(data);
+    data_header_t* current_header = reinterpret_cast<data_header_t*>(header_);
+    current_header->checksum = header.checksum;
+    current_header->snapshot_version = header.snapshot_version;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Base::get_snapshot_filename(char* filename, uint32_t length) {
+  __ENTER_FUNCTION
+    memset(filename, '\0', length);
+    snprintf(filename, 
+             length - 1, 
+             "%s/pap_%"PRIu64".snap", 
+             snapshot_path, 
+             key_);
+  __LEAVE_FUNCTION
+}
+
+bool Base::snapshot(const char* data) {
+  __ENTER_FUNCTION
+    Assert(data);
+    if (!header_ || !data) return false;
+    char filename[FILENAME_MAX + 32];
+    get_snapshot_filename(filename, sizeof(filename));
+    if (!dump(filename, data)) return false;
+    data_header_t* header = reinterpret_cast<data_header_t*>(header_);
+    header->checksum = checksum(data, size_ - sizeof(data_header_t));
+#if defined(__LINUX__)
+    if (kBackendMmapFile == backend_) return api::mmap_sync(header_, size_);
+#endif
     return true;
   __LEAVE_FUNCTION
     return false;
 }
 
+bool Base::restore_snapshot() {
+  __ENTER_FUNCTION
+    char filename[FILENAME_MAX + 32];
+    get_snapshot_filename(filename, sizeof(filename));
+    return merge_from_file(filename);
+  __LEAVE_FUNCTION
+    return false;
+}
+
 void Base::set_head_version(uint32_t version) {
   __ENTER_FUNCTION
     (reinterpret_cast<data_header_t*>(header_))->version = version;
@@ -316,55 +590,159 @@ uint32_t Base::get_head_version() {
 
 //-- functions start
 
-void lock(char &flag, char type) {
+void set_backend(int32_t type, bool huge_page, const char* path) {
   __ENTER_FUNCTION
-    _loop:
-    if (kUseFree == flag) {
-      flag = type;
-      if (flag != type) {
-        pap_common_base::util::sleep(1);
-#if defined(__LINUX__)
-        ++lock_times;
-        printf("[sharememory](lock) fail %s, %d, %s", 
-               __FILE__, 
-               __LINE__, 
-               __PRETTY_FUNCTION__);
-        if (lock_times < 100 && lock_time_enable) {
-          lock_times = 0;
-          return;
-        }
-#endif
-        goto _loop;
-      }
+    backend_type = type;
+    huge_page_enable = huge_page;
+    if (path && strlen(path) > 0) {
+      strncpy(mmap_file_path, path, sizeof(mmap_file_path) - 1);
+      mmap_file_path[sizeof(mmap_file_path) - 1] = '\0';
     }
-    else {
-      goto _loop;
+  __LEAVE_FUNCTION
+}
+
+void set_snapshot_path(const char* path) {
+  __ENTER_FUNCTION
+    if (path && strlen(path) > 0) {
+      strncpy(snapshot_path, path, sizeof(snapshot_path) - 1);
+      snapshot_path[sizeof(snapshot_path) - 1] = '\0';
     }
   __LEAVE_FUNCTION
 }
 
-bool trylock(char &flag, char type) {
+uint32_t checksum(const char* data, uint32_t size) {
+  __ENTER_FUNCTION
+    //Fletcher风格，按32位累加，数据区按结构体打包不保证对齐
+    uint32_t sum1 = 0;
+    uint32_t sum2 = 0;
+    uint32_t i;
+    uint32_t word;
+    for (i = 0; i + sizeof(word) <= size; i += sizeof(word)) {
+      memcpy(&word, data + i, sizeof(word));
+      sum1 += word;
+      sum2 += sum1;
+    }
+    for (; i < size; ++i) {
+      sum1 += static_cast<unsigned char>(data[i]);
+      sum2 += sum1;
+    }
+    return sum1 ^ (sum2 << 16 | sum2 >> 16);
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+//自旋 -> 让出时间片 -> 短睡眠，三段等待，不再每次失败都睡1毫秒
+const uint32_t kLockSpinCount = 128;
+const uint32_t kLockYieldCount = 64;
+const uint32_t kLockSleepMicroSeconds = 50;
+const uint32_t kLockTimeLimitRound = 100; //开启时间锁时，睡眠次数超过则放弃
+
+static bool flag_compare_and_swap(char &flag, char old_value, char new_value) {
+#if defined(__LINUX__)
+  return __sync_bool_compare_and_swap(&flag, old_value, new_value);
+#elif defined(__WINDOWS__)
+  //VS2008没有_InterlockedCompareExchange8，对标记所在的4字节对齐的字做
+  //比较交换，同一个字里的其他字节被改动时重试（x86为小端）
+  uintptr_t address = reinterpret_cast<uintptr_t>(&flag);
+  volatile LONG* word = 
+    reinterpret_cast<volatile LONG*>(address & ~static_cast<uintptr_t>(3));
+  uint32_t shift = static_cast<uint32_t>(address & 3) * 8;
+  uint32_t mask = 0xffU << shift;
+  uint32_t old_byte = static_cast<uint32_t>(static_cast<uint8_t>(old_value));
+  uint32_t new_byte = static_cast<uint32_t>(static_cast<uint8_t>(new_value));
+  for (;;) {
+    uint32_t current = static_cast<uint32_t>(*word);
+    if (((current & mask) >> shift) != old_byte) return false;
+    uint32_t exchange = (current & ~mask) | (new_byte << shift);
+    if (_InterlockedCompareExchange(word, 
+                                    static_cast<LONG>(exchange), 
+                                    static_cast<LONG>(current)) == 
+        static_cast<LONG>(current)) {
+      return true;
+    }
+  }
+#endif
+}
+
+static void memory_barrier() {
+#if defined(__LINUX__)
+  __sync_synchronize();
+#elif defined(__WINDOWS__)
+  MemoryBarrier();
+#endif
+}
+
+static void wait_round(uint32_t round) {
+  if (round < kLockSpinCount) {
+#if defined(__LINUX__) && (defined(__i386__) || defined(__x86_64__))
+    __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__WINDOWS__)
+    YieldProcessor();
+#endif
+  }
+  else if (round < kLockSpinCount + kLockYieldCount) {
+#if defined(__LINUX__)
+    sched_yield();
+#elif defined(__WINDOWS__)
+    SwitchToThread();
+#endif
+  }
+  else {
+#if defined(__LINUX__)
+    usleep(kLockSleepMicroSeconds);
+#elif defined(__WINDOWS__)
+    Sleep(0);
+#endif
+  }
+}
+
+void lock(char &flag, char type, uint32_t* contended) {
   __ENTER_FUNCTION
-    uint32_t _lock_times = 0;
-    _loop:
-    if (kUseFree == flag) {
-      flag = type;
-      if (flag != type) {
-        ++_lock_times;
-        pap_common_base::util::sleep(1);
-        if (_lock_times > 10) {
-          return false;
+    uint32_t round = 0;
+    while (!flag_compare_and_swap(flag, kFlagFree, type)) {
+      if (0 == round && contended) {
+#if defined(__LINUX__)
+        __sync_fetch_and_add(contended, 1);
+#elif defined(__WINDOWS__)
+        InterlockedIncrement(reinterpret_cast<volatile LONG*>(contended));
+#endif
+      }
+      //等待持有者释放时只读，不反复写缓存行
+      while (kFlagFree != *static_cast<volatile char*>(&flag)) {
+        wait_round(round);
+        ++round;
+#if defined(__LINUX__)
+        if (lock_time_enable && 
+            round > kLockSpinCount + kLockYieldCount + kLockTimeLimitRound) {
+          ++lock_times;
+          pap_server_common_base::Log::save_log(
+              "sharememory", 
+              "[sharememory](lock) time limit, flag = %d, type = %d", 
+              flag, 
+              type);
+          return; //持有者可能已经崩溃
         }
-        goto _loop;
+#endif
       }
     }
-    else {
-      ++_lock_times;
-      pap_common_base::util::sleep(1);
-      if (_lock_times > 10) {
-        return false;
+  __LEAVE_FUNCTION
+}
+
+bool trylock(char &flag, char type, uint32_t* contended) {
+  __ENTER_FUNCTION
+    uint32_t round = 0;
+    for (;;) {
+      if (flag_compare_and_swap(flag, kFlagFree, type)) return true;
+      if (0 == round && contended) {
+#if defined(__LINUX__)
+        __sync_fetch_and_add(contended, 1);
+#elif defined(__WINDOWS__)
+        InterlockedIncrement(reinterpret_cast<volatile LONG*>(contended));
+#endif
       }
-      goto _loop;
+      if (round >= kLockSpinCount + kLockYieldCount) return false;
+      wait_round(round);
+      ++round;
     }
   __LEAVE_FUNCTION
     return false;
@@ -373,23 +751,46 @@ bool trylock(char &flag, char type) {
 void unlock(char &flag, char type) {
   __ENTER_FUNCTION
     USE_PARAM(type);
-    _loop:
-      if (kUseFree == flag) return;
-      flag = kUseFree;
-      if (kUseFree != flag) {
-        pap_common_base::util::sleep(1);
-#if defined(__LINUX__)
-        printf("[sharememory](unlock)fail %s, %d, %s", 
-               __FILE__, 
-               __LINE__, 
-               __PRETTY_FUNCTION__);
-        if (lock_times > 100 && lock_time_enable) {
-          lock_times = 0;
-          return;
-        }
-#endif
-        goto _loop;
-      }
+    memory_barrier();
+    *static_cast<volatile char*>(&flag) = kFlagFree;
+  __LEAVE_FUNCTION
+}
+
+uint32_t read_begin(const uint32_t &sequence) {
+  __ENTER_FUNCTION
+    uint32_t round = 0;
+    uint32_t result;
+    for (;;) {
+      result = *static_cast<const volatile uint32_t*>(&sequence);
+      if (0 == (result & 1)) break;
+      wait_round(round);
+      ++round;
+    }
+    memory_barrier();
+    return result;
+  __LEAVE_FUNCTION
+    return 0;
+}
+
+bool read_retry(const uint32_t &sequence, uint32_t start) {
+  __ENTER_FUNCTION
+    memory_barrier();
+    return *static_cast<const volatile uint32_t*>(&sequence) != start;
+  __LEAVE_FUNCTION
+    return true;
+}
+
+void write_begin(uint32_t &sequence) {
+  __ENTER_FUNCTION
+    ++(*static_cast<volatile uint32_t*>(&sequence));
+    memory_barrier();
+  __LEAVE_FUNCTION
+}
+
+void write_end(uint32_t &sequence) {
+  __ENTER_FUNCTION
+    memory_barrier();
+    ++(*static_cast<volatile uint32_t*>(&sequence));
   __LEAVE_FUNCTION
 }
 
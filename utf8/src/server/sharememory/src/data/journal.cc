@@ -0,0 +1,281 @@
+#include "server/share_memory/data/journal.h"
+#include "server/common/sys/share_memory.h"
+#include "server/common/base/log.h"
+#if defined(__LINUX__)
+#include <unistd.h>
+#elif defined(__WINDOWS__)
+#include <io.h>
+#endif
+
+Journal::Journal() {
+  __ENTER_FUNCTION
+    key_ = 0;
+    memset(filename_, '\0', sizeof(filename_));
+    fp_ = NULL;
+    buffer_ = NULL;
+    buffer_size_ = 0;
+    buffer_count_ = 0;
+    replay_buffer_ = NULL;
+    replay_size_ = 0;
+    replay_position_ = 0;
+    imaged_bits_ = NULL;
+    slot_count_ = 0;
+  __LEAVE_FUNCTION
+}
+
+Journal::~Journal() {
+  __ENTER_FUNCTION
+    commit();
+    close();
+    SAFE_DELETE_ARRAY(buffer_);
+    SAFE_DELETE_ARRAY(replay_buffer_);
+    SAFE_DELETE_ARRAY(imaged_bits_);
+  __LEAVE_FUNCTION
+}
+
+bool Journal::init(uint64_t key, const char* path, uint32_t slot_count) {
+  __ENTER_FUNCTION
+    Assert(path);
+    key_ = key;
+    snprintf(filename_, 
+             sizeof(filename_) - 1, 
+             "%s/journal_%"PRIu64".log", 
+             path, 
+             key);
+    buffer_ = new char[kJournalBufferSize];
+    Assert(buffer_);
+    buffer_size_ = sizeof(journal_batch_t);
+    buffer_count_ = 0;
+    slot_count_ = slot_count;
+    uint32_t words = (slot_count_ + 31) / 32;
+    imaged_bits_ = new uint32_t[words > 0 ? words : 1];
+    Assert(imaged_bits_);
+    memset(imaged_bits_, 0, sizeof(uint32_t) * (words > 0 ? words : 1));
+    return open("ab");
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Journal::open(const char* mode) {
+  __ENTER_FUNCTION
+    close();
+    fp_ = fopen(filename_, mode);
+    if (!fp_) {
+      g_log->fast_save_log(kShareMemoryLogFile, 
+                           "[journal](open) failed, file: %s", 
+                           filename_);
+      return false;
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Journal::close() {
+  __ENTER_FUNCTION
+    if (fp_) {
+      fclose(fp_);
+      fp_ = NULL;
+    }
+  __LEAVE_FUNCTION
+}
+
+bool Journal::is_imaged(uint32_t slot) const {
+  __ENTER_FUNCTION
+    if (!imaged_bits_ || slot >= slot_count_) return false;
+    return 0 != (imaged_bits_[slot / 32] & (1U << (slot % 32)));
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void Journal::append_image(uint32_t slot, 
+                           const char* current, 
+                           uint32_t begin, 
+                           uint32_t end) {
+  __ENTER_FUNCTION
+    if (begin >= end) return;
+    append(kJournalRecordImage, slot, begin, current + begin, end - begin);
+    if (imaged_bits_ && slot < slot_count_) {
+      imaged_bits_[slot / 32] |= 1U << (slot % 32);
+    }
+  __LEAVE_FUNCTION
+}
+
+void Journal::append_diff(uint32_t slot, 
+                          const char* current, 
+                          const char* previous,
+                          uint32_t begin,
+                          uint32_t end) {
+  __ENTER_FUNCTION
+    uint32_t i = begin;
+    while (i < end) {
+      if (current[i] == previous[i]) {
+        ++i;
+        continue;
+      }
+      uint32_t start = i;
+      uint32_t last = i; //最后一个不同的字节
+      for (++i; i < end && i - last <= kJournalDiffGap; ++i) {
+        if (current[i] != previous[i]) last = i;
+      }
+      append(kJournalRecordDiff, 
+             slot, 
+             start, 
+             current + start, 
+             last - start + 1);
+      i = last + 1;
+    }
+  __LEAVE_FUNCTION
+}
+
+void Journal::append(uint32_t type,
+                     uint32_t slot, 
+                     uint32_t offset, 
+                     const char* data, 
+                     uint32_t size) {
+  __ENTER_FUNCTION
+    if (!buffer_) return;
+    while (size > 0) {
+      uint32_t left = kJournalBufferSize - buffer_size_;
+      if (left <= sizeof(journal_record_t)) {
+        commit();
+        continue;
+      }
+      uint32_t length = size;
+      if (length > left - sizeof(journal_record_t)) {
+        length = left - sizeof(journal_record_t);
+      }
+      journal_record_t record;
+      record.type = type;
+      record.slot = slot;
+      record.offset = offset;
+      record.size = length;
+      memcpy(buffer_ + buffer_size_, &record, sizeof(record));
+      memcpy(buffer_ + buffer_size_ + sizeof(record), data, length);
+      buffer_size_ += sizeof(record) + length;
+      ++buffer_count_;
+      offset += length;
+      data += length;
+      size -= length;
+      type = kJournalRecordDiff; //分段时只有第一段是整条记录的开始
+    }
+  __LEAVE_FUNCTION
+}
+
+bool Journal::commit() {
+  __ENTER_FUNCTION
+    if (!buffer_ || 0 == buffer_count_) return true;
+    if (!fp_) { //文件打不开时丢弃，避免缓冲一直满
+      buffer_size_ = sizeof(journal_batch_t);
+      buffer_count_ = 0;
+      return false;
+    }
+    journal_batch_t batch;
+    batch.magic = kJournalMagic;
+    batch.key = key_;
+    batch.length = buffer_size_ - sizeof(journal_batch_t);
+    batch.count = buffer_count_;
+    batch.checksum = pap_server_common_sys::share_memory::checksum(
+        buffer_ + sizeof(journal_batch_t), 
+        batch.length);
+    memcpy(buffer_, &batch, sizeof(batch));
+    bool result = 1 == fwrite(buffer_, buffer_size_, 1, fp_);
+    result = 0 == fflush(fp_) && result;
+#if defined(__LINUX__)
+    result = 0 == fdatasync(fileno(fp_)) && result;
+#elif defined(__WINDOWS__)
+    result = 0 == _commit(_fileno(fp_)) && result;
+#endif
+    buffer_size_ = sizeof(journal_batch_t);
+    buffer_count_ = 0;
+    if (!result) {
+      g_log->fast_save_log(kShareMemoryLogFile, 
+                           "[journal](commit) failed, file: %s", 
+                           filename_);
+    }
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Journal::checkpoint() {
+  __ENTER_FUNCTION
+    if (!commit()) return false;
+    if (imaged_bits_) {
+      memset(imaged_bits_, 0, sizeof(uint32_t) * ((slot_count_ + 31) / 32));
+    }
+    return open("wb") && open("ab");
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Journal::load() {
+  __ENTER_FUNCTION
+    SAFE_DELETE_ARRAY(replay_buffer_);
+    replay_size_ = 0;
+    replay_position_ = 0;
+    FILE* fp = fopen(filename_, "rb");
+    if (!fp) return false;
+    fseek(fp, 0L, SEEK_END);
+    int32_t filelength = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    if (filelength <= 0) {
+      fclose(fp);
+      return false;
+    }
+    replay_buffer_ = new char[filelength];
+    Assert(replay_buffer_);
+    //批次逐个校验，遇到写了一半的批次就停止
+    uint32_t batch_count = 0;
+    journal_batch_t batch;
+    while (1 == fread(&batch, sizeof(batch), 1, fp)) {
+      if (batch.magic != kJournalMagic || 
+          batch.key != key_ ||
+          batch.length > static_cast<uint32_t>(filelength) - replay_size_) {
+        break;
+      }
+      if (1 != fread(replay_buffer_ + replay_size_, batch.length, 1, fp) ||
+          batch.checksum != pap_server_common_sys::share_memory::checksum(
+            replay_buffer_ + replay_size_, batch.length)) {
+        break;
+      }
+      replay_size_ += batch.length;
+      ++batch_count;
+    }
+    fclose(fp);
+    g_log->fast_save_log(kShareMemoryLogFile, 
+                         "[journal](load) file: %s, batch: %u, size: %u",
+                         filename_,
+                         batch_count,
+                         replay_size_);
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool Journal::next_record(uint32_t &type,
+                          uint32_t &slot, 
+                          uint32_t &offset, 
+                          uint32_t &size, 
+                          const char* &data) {
+  __ENTER_FUNCTION
+    if (!replay_buffer_ || 
+        replay_position_ + sizeof(journal_record_t) > replay_size_) {
+      return false;
+    }
+    journal_record_t record;
+    memcpy(&record, replay_buffer_ + replay_position_, sizeof(record));
+    if (record.size > 
+        replay_size_ - replay_position_ - sizeof(journal_record_t)) {
+      return false;
+    }
+    type = record.type;
+    slot = record.slot;
+    offset = record.offset;
+    size = record.size;
+    data = replay_buffer_ + replay_position_ + sizeof(journal_record_t);
+    replay_position_ += sizeof(journal_record_t) + record.size;
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
@@ -11,8 +11,6 @@ using namespace pap_server_common_game::db::share_memory;
 using namespace pap_server_common_sys::share_memory;
 using namespace pap_server_common_base;
 
-const uint32_t kIntervalSaveTime = 30000; //需要循环保存数据储存的时间间隔
-
 //全局数据操作的实现
 template<>
 bool LogicManager<global_data_t>::save_all() {
@@ -34,10 +32,12 @@ bool LogicManager<global_data_t>::save_all() {
       Assert(global_data);
       return false;
     }
+    //先取版本再取数据，期间若有写入则下次仍然是脏数据
+    uint32_t version = global_data->get_version(kFlagSelfRead);
     data = global_data->get_data(kFlagSelfRead);
     //uint64_t key = pool_pointer_->get_key();
     pap_server_common_db::ODBCInterface* odbc_interface = 
-      g_db_manager->get_interface(kCharacterDatabase);
+      db_manager_->get_interface(kCharacterDatabase);
     Assert(odbc_interface);
 	  pap_server_common_db::data::Global _global_data(odbc_interface);
     _global_data.set_pool_id(100);
@@ -48,8 +48,21 @@ bool LogicManager<global_data_t>::save_all() {
     else {
       Log::save_log("sharememory", "global data save error.");
       Assert(false);
+      return false;
+    }
+    global_data->set_save_version(version, kFlagSelfWrite);
+    pool_pointer_->clear_dirty(0);
+    //快照只在存盘之后做，和数据库中的数据对应，快照写成功以后日志才能
+    //截断，否则恢复时只有旧的快照和空的日志
+    if (!pool_pointer_->snapshot()) {
+      Log::save_log("sharememory", "global data snapshot error.");
+      Assert(false);
+      return false;
     }
-    Log::save_log("sharememory", "global data save ok.");
+    if (journal_) journal_->checkpoint();
+    Log::save_log("sharememory", 
+                  "global data save ok, lock contended: %"PRIu64".",
+                  pool_pointer_->get_lock_contended());
     return true;
   __LEAVE_FUNCTION
     return false;
@@ -60,9 +73,10 @@ bool LogicManager<global_data_t>::normal_save() {
   __ENTER_FUNCTION
     bool result = false;
     uint32_t run_time = g_time_manager->get_run_time();
-    if (run_time > last_save_time_ + kIntervalSaveTime) {
-      result = save_all();
+    if (run_time > last_save_time_ + save_interval_) {
       last_save_time_ = run_time;
+      if (0 == pool_pointer_->scan_dirty()) return true; //没有修改则不保存
+      result = save_all();
     }
     return result;
   __LEAVE_FUNCTION
@@ -93,7 +107,7 @@ bool LogicManager<global_data_t>::post_init() {
     }
     //uint32_t _data = global_data->get_data(kFlagSelfRead);
     pap_server_common_db::ODBCInterface* odbc_interface = 
-      g_db_manager->get_interface(kCharacterDatabase);
+      db_manager_->get_interface(kCharacterDatabase);
     Assert(odbc_interface);
     uint32_t _data = 100; //test
 	  pap_server_common_db::data::Global _global_data(odbc_interface);
@@ -105,6 +119,9 @@ bool LogicManager<global_data_t>::post_init() {
     if (_data > 0) {
       global_data->set_data(kFlagSelfWrite, _data);
       _data = global_data->get_data(kFlagSelfRead);
+      //刚从数据库载入的数据不需要再保存
+      global_data->set_save_version(global_data->get_version(kFlagSelfRead), 
+                                    kFlagSelfWrite);
     }
     else {
       Assert(false);
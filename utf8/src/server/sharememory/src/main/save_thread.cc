@@ -0,0 +1,162 @@
+#include "server/share_memory/main/save_thread.h"
+#include "server/share_memory/data/logic_manager.h"
+#include "server/common/game/db/struct.h"
+#include "server/common/base/log.h"
+#include "common/base/util.h"
+
+SaveThread::SaveThread() {
+  __ENTER_FUNCTION
+    active_ = true;
+    logic_manager_ = NULL;
+    using namespace pap_server_common_game::define;
+    key_type_ = type::sharememory::kKeyInvalid;
+    db_manager_ = NULL;
+    command_ = kCmdUnkown;
+    command_done_ = true;
+  __LEAVE_FUNCTION
+}
+
+SaveThread::~SaveThread() {
+  __ENTER_FUNCTION
+    SAFE_DELETE(db_manager_);
+  __LEAVE_FUNCTION
+}
+
+bool SaveThread::init(
+    void* logic_manager, 
+    pap_server_common_game::define::type::sharememory::key_enum key_type,
+    uint32_t save_interval) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_game::define;
+    using namespace pap_server_common_game::db::share_memory;
+    Assert(logic_manager);
+    if (!logic_manager) return false;
+    logic_manager_ = logic_manager;
+    key_type_ = key_type;
+    db_manager_ = new pap_server_common_db::Manager();
+    Assert(db_manager_);
+    bool result = db_manager_->init(kCharacterDatabase);
+    g_log->fast_save_log(kShareMemoryLogFile, 
+                         "[save thread](init) key type: %d, interval: %u,"
+                         " connect database %s",
+                         key_type_,
+                         save_interval,
+                         result ? "success" : "failed");
+    switch (key_type_) {
+      case type::sharememory::kKeyGlobalData: {
+        LogicManager<global_data_t>* globaldata_manager =
+          static_cast<LogicManager<global_data_t>*>(logic_manager_);
+        globaldata_manager->set_db_manager(db_manager_);
+        globaldata_manager->set_save_interval(save_interval);
+        break;
+      }
+      default: {
+        AssertEx(false, "SaveThread::init unkown key type");
+        return false;
+      }
+    }
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void SaveThread::run() {
+  __ENTER_FUNCTION
+    while (is_active()) {
+      command_enum command;
+      lock_.lock();
+      command = command_;
+      command_ = kCmdUnkown;
+      lock_.unlock();
+      if (check_connection() || command != kCmdUnkown) {
+        heartbeat(command);
+      }
+      if (command != kCmdUnkown) {
+        lock_.lock();
+        command_done_ = true;
+        lock_.unlock();
+      }
+      pap_common_base::util::sleep(kSaveThreadSleepTime);
+    }
+  __LEAVE_FUNCTION
+}
+
+void SaveThread::stop() {
+  __ENTER_FUNCTION
+    active_ = false;
+  __LEAVE_FUNCTION
+}
+
+bool SaveThread::is_active() {
+  __ENTER_FUNCTION
+    return active_;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+void SaveThread::post_command(command_enum command) {
+  __ENTER_FUNCTION
+    lock_.lock();
+    command_ = command;
+    command_done_ = false;
+    lock_.unlock();
+  __LEAVE_FUNCTION
+}
+
+bool SaveThread::is_command_done() {
+  __ENTER_FUNCTION
+    bool result;
+    lock_.lock();
+    result = command_done_;
+    lock_.unlock();
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool SaveThread::heartbeat(command_enum command) {
+  __ENTER_FUNCTION
+    using namespace pap_server_common_game::define;
+    using namespace pap_server_common_game::db::share_memory;
+    bool result = false;
+    switch (key_type_) {
+      case type::sharememory::kKeyGlobalData: {
+        LogicManager<global_data_t>* globaldata_manager =
+          static_cast<LogicManager<global_data_t>*>(logic_manager_);
+        result = globaldata_manager->heartbeat(command);
+        break;
+      }
+      default: {
+        AssertEx(false, "SaveThread::heartbeat unkown key type");
+      }
+    }
+    return result;
+  __LEAVE_FUNCTION
+    return false;
+}
+
+bool SaveThread::check_connection() {
+  __ENTER_FUNCTION
+    pap_server_common_db::ODBCInterface* odbc_interface =
+      db_manager_->get_interface(kCharacterDatabase);
+    Assert(odbc_interface);
+    if (odbc_interface->is_connected()) return true;
+    g_log->fast_save_log(kShareMemoryLogFile, 
+                         "[save thread] key type: %d connect database failed",
+                         key_type_);
+    if (!odbc_interface->connect()) {
+      g_log->fast_save_log(kShareMemoryLogFile,
+                           "[save thread] key type: %d"
+                           " try connect database failed",
+                           key_type_);
+      pap_common_base::util::sleep(5000);
+      return false;
+    }
+    g_log->fast_save_log(kShareMemoryLogFile, 
+                         "[save thread] key type: %d"
+                         " try connect database success",
+                         key_type_);
+    return true;
+  __LEAVE_FUNCTION
+    return false;
+}
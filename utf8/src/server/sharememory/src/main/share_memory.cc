@@ -84,6 +84,7 @@ int32_t main(int32_t argc, char* argv[]) {
 ShareMemory::ShareMemory() {
   __ENTER_FUNCTION
     exited_ = false;
+    memset(savethread_pool_, 0, sizeof(savethread_pool_));
   __LEAVE_FUNCTION
 }
 
@@ -124,6 +125,10 @@ bool ShareMemory::loop() {
       g_command_thread.start();
       Log::save_log("sharememory", "g_command_thread.start()");
     }
+    uint32_t i;
+    for (i = 0; i < pap_server_common_sys::share_memory::kObjMax; ++i) {
+      if (savethread_pool_[i]) savethread_pool_[i]->start();
+    }
     Log::save_log("sharememory", "loop ... start");
     for (;;) {
       work();
@@ -155,26 +160,6 @@ bool ShareMemory::work() {
     uint32_t daytime = g_time_manager->get_day_time();
     if (static_cast<uint32_t>(g_file_name_fix) != daytime) 
       g_file_name_fix = daytime;
-    ODBCInterface* odbc_interface =
-      g_db_manager->get_interface(kCharacterDatabase);
-    Assert(odbc_interface);
-    if (!odbc_interface->is_connected()) {
-      g_log->fast_save_log(kShareMemoryLogFile, "connect database failed");
-      bool connectresult = false;
-      connectresult = odbc_interface->connect();
-      if (!connectresult) {
-        g_log->fast_save_log(kShareMemoryLogFile,
-                             "try connect database failed");
-        util::sleep(5000);
-        if (kCmdUnkown == g_command_thread.command_config.state.type) {
-          return false;
-        }
-      }
-      else {
-        g_log->fast_save_log(kShareMemoryLogFile, 
-                             "try connect database success");
-      }
-    }
 
     if (check_saveall_file()) {
       g_command_thread.command_config.state.type = kCmdSaveAll;
@@ -196,31 +181,11 @@ bool ShareMemory::work() {
       g_command_thread.command_config.state.type = kCmdUnkown;
     }
  
-    uint32_t i;
-    for (i = 0; i < share_memory::kObjMax; ++i) {
-      if (logicmanager_pool_[i].logic_manager) {
-        type::sharememory::key_enum key_type;
-        key_type = logicmanager_pool_[i].key_type;
-        switch (key_type) {
-          case type::sharememory::kKeyGlobalData: {
-            LogicManager<global_data_t>* globaldata_manager =
-              static_cast<LogicManager<global_data_t>*>(
-                  logicmanager_pool_[i].logic_manager);
-            if (globaldata_manager) {
-              globaldata_manager->heartbeat();
-            }
-            else {
-              AssertEx(false, "ShareMemory::work run time error");
-            }
-            break;
-          }
-          default: {
-            AssertEx(false, "ShareMemory::work unkown key type");
-          }
-        }
-      }
+    //各个池的心跳与存储在各自的存储线程中进行
+    if (g_command_config.state.type != kCmdUnkown) {
+      post_command(g_command_config.state.type);
     }
-   
+
     if (kCmdClearAll == g_command_config.state.type) {
       exit(0);
     }
@@ -300,6 +265,9 @@ bool ShareMemory::init_staticmanager() {
       key_enum key_type;
       key_type = static_cast<key_enum>(
           g_config.share_memory_info_.key_data[i].type);
+      uint32_t save_interval = type::sharememory::kKeyHuman == key_type ? 
+        g_config.share_memory_info_.human_data_save_interval : 
+        g_config.share_memory_info_.world_data_save_interval;
       switch (key_type) {
         case type::sharememory::kKeyGlobalData: {
           UnitPool<global_data_t>* global_pool;
@@ -316,6 +284,18 @@ bool ShareMemory::init_staticmanager() {
           Assert(global_logicmanager);
           result = global_logicmanager->init(global_pool);
           Assert(result);
+          if (g_config.share_memory_info_.journal) {
+            result = global_logicmanager->init_journal(
+                g_config.share_memory_info_.journal_path);
+            Assert(result);
+          }
+          savethread_pool_[i] = new SaveThread();
+          Assert(savethread_pool_[i]);
+          result = savethread_pool_[i]->init(
+              global_logicmanager, 
+              key_type, 
+              save_interval);
+          Assert(result);
           break;
         }
         default: {
@@ -338,6 +318,17 @@ bool ShareMemory::release_staticmanager() {
     bool result = true;
     uint32_t i;
     uint16_t obj_count = g_config.share_memory_info_.obj_count;
+    for (i = 0; i < pap_server_common_sys::share_memory::kObjMax; ++i) {
+      if (savethread_pool_[i]) savethread_pool_[i]->stop();
+    }
+    for (i = 0; i < pap_server_common_sys::share_memory::kObjMax; ++i) {
+      if (!savethread_pool_[i]) continue;
+      while (savethread_pool_[i]->get_status() == 
+             pap_common_sys::Thread::kRunning) {
+        pap_common_base::util::sleep(100);
+      }
+      SAFE_DELETE(savethread_pool_[i]);
+    }
     for (i = 0; i < obj_count; ++i) {
       typedef type::sharememory::key_enum key_enum;
       key_enum _type;
@@ -366,6 +357,21 @@ bool ShareMemory::release_staticmanager() {
     return false;
 }
 
+void ShareMemory::post_command(command_enum command) {
+  __ENTER_FUNCTION
+    uint32_t i;
+    for (i = 0; i < pap_server_common_sys::share_memory::kObjMax; ++i) {
+      if (savethread_pool_[i]) savethread_pool_[i]->post_command(command);
+    }
+    for (i = 0; i < pap_server_common_sys::share_memory::kObjMax; ++i) {
+      if (!savethread_pool_[i]) continue;
+      while (!savethread_pool_[i]->is_command_done()) {
+        pap_common_base::util::sleep(100);
+      }
+    }
+  __LEAVE_FUNCTION
+}
+
 bool check_saveall_file() {
   __ENTER_FUNCTION
     bool result = true;
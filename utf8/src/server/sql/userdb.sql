@@ -567,6 +567,39 @@ CREATE TABLE IF NOT EXISTS `users` (
   KEY `IX_users_creatime` (`creatime`)
 ) ENGINE=MyISAM DEFAULT CHARSET=utf8 COMMENT='用户表';
 
+-- --------------------------------------------------------
+
+--
+-- 表的结构 `yuanbao`
+--
+
+CREATE TABLE IF NOT EXISTS `yuanbao` (
+  `name` varchar(32) NOT NULL DEFAULT '' COMMENT '用户名',
+  `balance` int(10) unsigned NOT NULL DEFAULT '0' COMMENT '元宝余额',
+  `daycost` int(10) unsigned NOT NULL DEFAULT '0' COMMENT '当天已消费',
+  `costday` int(10) unsigned NOT NULL DEFAULT '0' COMMENT '消费日期',
+  PRIMARY KEY (`name`)
+) ENGINE=MyISAM DEFAULT CHARSET=utf8 COMMENT='元宝余额';
+
+-- --------------------------------------------------------
+
+--
+-- 表的结构 `yuanbaojournal`
+--
+
+CREATE TABLE IF NOT EXISTS `yuanbaojournal` (
+  `id` int(10) unsigned NOT NULL AUTO_INCREMENT,
+  `name` varchar(32) NOT NULL DEFAULT '' COMMENT '用户名',
+  `requestkey` varchar(32) NOT NULL DEFAULT '' COMMENT '请求的幂等键',
+  `amount` int(11) NOT NULL DEFAULT '0' COMMENT '变化量，负数为消费',
+  `balance` int(10) unsigned NOT NULL DEFAULT '0' COMMENT '之后的余额',
+  `time` int(10) unsigned NOT NULL DEFAULT '0' COMMENT '时间',
+  PRIMARY KEY (`id`),
+  UNIQUE KEY `IX_yuanbaojournal_requestkey` (`name`, `requestkey`),
+  KEY `IX_yuanbaojournal_name` (`name`),
+  KEY `IX_yuanbaojournal_time` (`time`)
+) ENGINE=MyISAM DEFAULT CHARSET=utf8 COMMENT='元宝日志';
+
 /*!40101 SET CHARACTER_SET_CLIENT=@OLD_CHARACTER_SET_CLIENT */;
 /*!40101 SET CHARACTER_SET_RESULTS=@OLD_CHARACTER_SET_RESULTS */;
 /*!40101 SET COLLATION_CONNECTION=@OLD_COLLATION_CONNECTION */;
@@ -0,0 +1,186 @@
+#include <time.h>
+#include <ctype.h>
+#include <algorithm>
+#include "common/file/database.h"
+
+//载入times次，返回平均毫秒数，失败返回-1
+double benchmark(const char* filename, int32_t times) {
+  clock_t begin = clock();
+  int32_t i;
+  for (i = 0; i < times; ++i) {
+    pap_common_file::Database database(0);
+    if (!database.open_from_txt(filename)) return -1.0;
+  }
+  clock_t end = clock();
+  return (static_cast<double>(end - begin) * 1000 / CLOCKS_PER_SEC) / times;
+}
+
+//列名不是合法的标识符时使用field<列号>
+std::string field_name(const std::string &name, int32_t column) {
+  bool valid = !name.empty() && !isdigit(static_cast<unsigned char>(name[0]));
+  uint32_t i;
+  for (i = 0; i < name.size() && valid; ++i) {
+    unsigned char letter = static_cast<unsigned char>(name[i]);
+    valid = letter < 0x80 && (isalnum(letter) || '_' == letter);
+  }
+  char temp[32];
+  snprintf(temp, sizeof(temp) - 1, "field%d", column);
+  temp[sizeof(temp) - 1] = '\0';
+  return valid ? name : std::string(temp);
+}
+
+//根据表头生成类型化的行访问类
+bool generate_header(const char* source, 
+                     const char* class_name, 
+                     const char* destination) {
+  FILE* fp = fopen(source, "rb");
+  if (!fp) return false;
+  char line[(1024 * 10) + 1]; //long string
+  std::vector<std::string> type;
+  std::vector<std::string> name;
+  if (fgets(line, sizeof(line) - 1, fp)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    pap_common_file::Database::convert_string_tovector(
+        line, type, "\t", true, true);
+  }
+  if (fgets(line, sizeof(line) - 1, fp)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    pap_common_file::Database::convert_string_tovector(
+        line, name, "\t", true, false);
+  }
+  fclose(fp);
+  if (type.empty()) return false;
+  fp = fopen(destination, "wb");
+  if (!fp) return false;
+  std::string guard = "PAP_TABLE_";
+  const char* letter;
+  for (letter = class_name; *letter; ++letter) {
+    guard.push_back(static_cast<char>(toupper(*letter)));
+  }
+  guard.append("_H_");
+  fprintf(fp, "//generated by tablecompiler from %s, don't edit it%s", 
+          source, LF);
+  fprintf(fp, "#ifndef %s%s#define %s%s%s", 
+          guard.c_str(), LF, guard.c_str(), LF, LF);
+  fprintf(fp, "#include \"common/file/database.h\"%s%s", LF, LF);
+  fprintf(fp, "class %s {%s%s", class_name, LF, LF);
+  fprintf(fp, " public:%s", LF);
+  fprintf(fp, "   typedef pap_common_file::Database database_t;%s", LF);
+  fprintf(fp, "   enum {kFieldNumber = %d};%s%s", 
+          static_cast<int32_t>(type.size()), LF, LF);
+  fprintf(fp, " public:%s", LF);
+  fprintf(fp, "   explicit %s(const database_t::field_data* row) : "
+              "row_(row) {}%s", class_name, LF);
+  fprintf(fp, "   bool valid() const { return row_ != NULL; }%s", LF);
+  std::vector<std::string> used;
+  std::string check;
+  uint32_t i;
+  for (i = 0; i < type.size(); ++i) {
+    int32_t column = static_cast<int32_t>(i);
+    std::string _name = 
+      field_name(i < name.size() ? name[i] : std::string(""), column);
+    if (std::find(used.begin(), used.end(), _name) != used.end()) {
+      _name = field_name("", column);
+    }
+    used.push_back(_name);
+    const char* return_type = "int32_t";
+    const char* value = "int_value";
+    const char* field_type = "kTypeInt";
+    if ("FLOAT" == type[i]) {
+      return_type = "float";
+      value = "float_value";
+      field_type = "kTypeFloat";
+    }
+    else if ("STRING" == type[i]) {
+      return_type = "const char*";
+      value = "string_value";
+      field_type = "kTypeString";
+    }
+    else if (type[i] != "INT") {
+      fclose(fp);
+      return false;
+    }
+    fprintf(fp, "   %s %s() const { return row_[%d].%s; }%s", 
+            return_type, _name.c_str(), column, value, LF);
+    char temp[128];
+    snprintf(temp, 
+             sizeof(temp) - 1, 
+             "%s            database->get_field_type(%d) == database_t::%s", 
+             0 == i ? "" : " &&\n", 
+             column, 
+             field_type);
+    temp[sizeof(temp) - 1] = '\0';
+    check.append(temp);
+  }
+  fprintf(fp, "%s   //表结构和生成时是否一致%s", LF, LF);
+  fprintf(fp, "   static bool check(const database_t* database) {%s", LF);
+  fprintf(fp, "     return database->get_field_number() == kFieldNumber &&%s"
+              "%s;%s", LF, check.c_str(), LF);
+  fprintf(fp, "   }%s%s", LF, LF);
+  fprintf(fp, " private:%s", LF);
+  fprintf(fp, "   const database_t::field_data* row_;%s%s", LF, LF);
+  fprintf(fp, "};%s%s#endif //%s%s", LF, LF, guard.c_str(), LF);
+  fclose(fp);
+  return true;
+}
+
+//usage: tablecompiler source.txt destination.tab
+//       tablecompiler -benchmark source.txt [times]
+//       tablecompiler -header source.txt ClassName destination.h
+int32_t main(int32_t argc, char* argv[]) {
+  if (argc < 3) {
+    printf("usage: %s source.txt destination.tab%s", argv[0], LF);
+    printf("       %s -benchmark source.txt [times]%s", argv[0], LF);
+    printf("       %s -header source.txt ClassName destination.h%s", 
+           argv[0], 
+           LF);
+    return 1;
+  }
+  if (0 == strcmp(argv[1], "-header")) {
+    if (argc < 5 || !generate_header(argv[2], argv[3], argv[4])) {
+      printf("generate %s failed%s", argc < 5 ? "header" : argv[4], LF);
+      return 1;
+    }
+    printf("%s -> %s%s", argv[2], argv[4], LF);
+    return 0;
+  }
+  if (0 == strcmp(argv[1], "-benchmark")) {
+    int32_t times = argc > 3 ? atoi(argv[3]) : 10;
+    if (times <= 0) times = 1;
+    double cost = benchmark(argv[2], times);
+    if (cost < 0) {
+      printf("open %s failed%s", argv[2], LF);
+      return 1;
+    }
+    printf("%s load %d times, average: %.3fms%s", argv[2], times, cost, LF);
+    return 0;
+  }
+  const char* source = argv[1];
+  const char* destination = argv[2];
+  pap_common_file::Database text_database(0);
+  if (!text_database.open_from_txt(source)) {
+    printf("open %s failed%s", source, LF);
+    return 1;
+  }
+  if (!text_database.save_to_binary(destination)) {
+    printf("save %s failed%s", destination, LF);
+    return 1;
+  }
+  //重新载入二进制表检查一次
+  pap_common_file::Database binary_database(0);
+  if (!binary_database.open_from_txt(destination) ||
+      binary_database.get_record_number() != 
+      text_database.get_record_number() ||
+      binary_database.get_field_number() != 
+      text_database.get_field_number()) {
+    printf("check %s failed%s", destination, LF);
+    return 1;
+  }
+  printf("%s -> %s, record: %d, field: %d%s", 
+         source, 
+         destination, 
+         binary_database.get_record_number(), 
+         binary_database.get_field_number(),
+         LF);
+  return 0;
+}